@@ -0,0 +1,172 @@
+#pragma once
+
+// Coroutine-based processing of data from asynchronous sources (C++20).
+
+#include "processor.h"
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+/// Lazily started coroutine returning a value; awaiting it starts it and
+/// resumes the awaiter when it completes.
+template<typename T>
+class XmlTask
+{
+    public:
+
+    struct promise_type
+    {
+        T value{};
+        std::coroutine_handle<> continuation;
+
+        XmlTask get_return_object() noexcept
+        { return XmlTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        auto final_suspend() noexcept
+        {
+            struct awaiter
+            {
+                bool await_ready() noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept
+                {
+                    auto c = h.promise().continuation;
+                    return c ? c : std::noop_coroutine();
+                }
+                void await_resume() noexcept {}
+            };
+            return awaiter{};
+        }
+        void return_value(T v) noexcept { value = std::move(v); }
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+
+    XmlTask(XmlTask&& t) noexcept : _h(std::exchange(t._h, {})) {}
+    XmlTask(const XmlTask&) = delete;
+    ~XmlTask() { if (_h) _h.destroy(); }
+
+    /// Starts or continues the coroutine when it is not awaited by another one.
+    void resume() noexcept { _h.resume(); }
+
+    /// True if the coroutine has completed.
+    bool done() const noexcept { return _h.done(); }
+
+    /// Gets the returned value; valid when done().
+    const T& result() const noexcept { return _h.promise().value; }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept
+    {
+        _h.promise().continuation = awaiter;
+        return _h;
+    }
+    T await_resume() noexcept { return std::move(_h.promise().value); }
+
+    private:
+
+    explicit XmlTask(std::coroutine_handle<promise_type> h) noexcept : _h(h) {}
+    std::coroutine_handle<promise_type> _h;
+};
+
+/// Feeds XmlParser in stream mode from an asynchronous source, so that
+/// waiting for data suspends the calling coroutine instead of blocking
+/// the thread. Items in the data read already come without suspending.
+/// An item the data ends in is scanned again from its start after each read
+/// (see XmlParser::needsInput()), which costs its length squared over the
+/// read size; so texts come in pieces of the read size unless the parser has
+/// a smaller Limits::maxTextChunk, and Limits::maxTagLength bounds the cost 
+/// of long comments, PIs and DTDs.
+/// \tparam Source Class with read(char* data, std::size_t n) returning an
+/// awaitable which yields the number of bytes read, 0 at the end of data.
+///
+///     XmlTask<bool> parse(Upload& upload)
+///     {
+///         XmlParser p;
+///         AsyncItemStream<Upload> items(p, upload);
+///         while (co_await items.next())
+///         {
+///             ...
+///         }
+///         co_return !p.error();
+///     }
+template<class Source>
+class AsyncItemStream
+{
+    public:
+
+    static const std::size_t default_read_size = 0x10000;
+
+    /// Constructor; puts the parser in stream mode and limits its text 
+    /// pieces to the read size if it has no limit.
+    ///\ param readSize Size of data asked from the source at once.
+    AsyncItemStream(XmlParser& parser, Source& source,
+        std::size_t readSize = default_read_size) noexcept :
+        _parser(parser), _source(source), _data(readSize)
+    {
+        if (!_parser.getLimits().maxTextChunk)
+        {
+            auto limits = _parser.getLimits();
+            limits.maxTextChunk = readSize;
+            _parser.setLimits(limits);
+        }
+        _parser.openStream();
+    }
+
+    XmlParser& getParser() noexcept { return _parser; }
+
+    /// Awaitable of next(); ready at once unless the data must be read.
+    class NextAwaiter
+    {
+        public:
+        bool await_ready() noexcept
+        {
+            _result = _stream._parser.next();
+            return _result || !_stream._parser.needsInput();
+        }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept
+        {
+            _stream._refill.emplace(_stream.refill());
+            return _stream._refill->await_suspend(awaiter);
+        }
+        bool await_resume() noexcept
+        {
+            if (!_stream._refill) return _result;
+            _result = _stream._refill->await_resume();
+            _stream._refill.reset();
+            return _result;
+        }
+        private:
+        friend class AsyncItemStream;
+        explicit NextAwaiter(AsyncItemStream& stream) noexcept : _stream(stream) {}
+        AsyncItemStream& _stream;
+        bool _result = false;
+    };
+
+    /// Loads next item, reading from the source as needed.
+    /// \return (when awaited) Same as XmlParser::next() at the end of data.
+    NextAwaiter next() noexcept { return NextAwaiter(*this); }
+
+    private:
+
+    XmlParser& _parser;
+    Source& _source;
+    std::vector<char> _data;
+    std::optional<XmlTask<bool> > _refill;  // reading, while next() is suspended
+
+    XmlTask<bool> refill()
+    {
+        for (;;)
+        {
+            std::size_t n = co_await _source.read(_data.data(), _data.size());
+            if (n) _parser.feed(_data.data(), n);
+            else _parser.finish();
+            if (_parser.next()) co_return true;
+            if (!_parser.needsInput()) co_return false;
+        }
+    }
+};
+
+#endif
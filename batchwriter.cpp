@@ -0,0 +1,234 @@
+#include "batchwriter.h"
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <climits>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+//=====================     Initialization    ==================================//
+
+BatchFileWriter::BatchFileWriter(std::size_t batchSize, std::size_t blockSize) noexcept :
+    _batchSize(batchSize),
+    _blockSize(std::max<std::size_t>(blockSize, 0x100)),
+    _error(false),
+    _maxQueued(0),
+    _busy(false),
+    _stop(false)
+{
+}
+
+bool BatchFileWriter::openFile(const char* path) noexcept
+{
+#ifdef _WIN32
+    int fd = _open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    if (fd < 0) return false;
+    _files.push_back(File{ fd, {}, 0 });
+    return true;
+}
+
+bool BatchFileWriter::openFiles(std::initializer_list<const char*> paths) noexcept
+{
+    for (auto path : paths)
+    {
+        if (!openFile(path))
+        {
+            closeFiles();
+            return false;
+        }
+    }
+    return true;
+}
+
+void BatchFileWriter::startThread(std::size_t maxQueued) noexcept
+{
+    if (_thread.joinable()) return;
+    _maxQueued = std::max<std::size_t>(maxQueued, 1);
+    _stop = false;
+    _thread = std::thread(&BatchFileWriter::run, this);
+}
+
+void BatchFileWriter::stopThread() noexcept
+{
+    if (!_thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        _stop = true;
+    }
+    _queueChanged.notify_all();
+    _thread.join();
+}
+
+void BatchFileWriter::closeFiles() noexcept
+{
+    flush();
+    stopThread();
+    for (auto& f : _files)
+    {
+#ifdef _WIN32
+        _close(f.fd);
+#else
+        ::close(f.fd);
+#endif
+    }
+    _files.clear();
+}
+
+BatchFileWriter::~BatchFileWriter()
+{
+    closeFiles();
+    for (auto p : _blocks) delete[] p;
+}
+
+//=====================     Write    ==================================//
+
+char* BatchFileWriter::allocBlock() noexcept
+{
+    std::lock_guard<std::mutex> lock(_poolMutex);
+    if (!_pool.empty())
+    {
+        auto p = _pool.back();
+        _pool.pop_back();
+        return p;
+    }
+    auto p = new char[_blockSize];
+    _blocks.push_back(p);
+    return p;
+}
+
+void BatchFileWriter::write(const char* data, std::size_t n, std::size_t userIndex) noexcept
+{
+    if (userIndex >= _files.size())
+    {
+        _error = true;
+        return;
+    }
+    auto& f = _files[userIndex];
+    if (n >= _blockSize && !_thread.joinable()) // write along with pending ones, no copy
+    {
+        Batch b{ f.fd, std::move(f.pending) };
+        f.pending.clear();
+        f.nPending = 0;
+        writeBatch(b, data, n);
+        return;
+    }
+    while (n)
+    {
+        if (f.pending.empty() || f.pending.back().size == _blockSize)
+        {
+            f.pending.push_back(Chunk{ allocBlock(), 0 });
+        }
+        auto& c = f.pending.back();
+        auto k = std::min(n, _blockSize - c.size);
+        memcpy(c.data + c.size, data, k);
+        c.size += k;
+        f.nPending += k;
+        data += k;
+        n -= k;
+    }
+    if (f.nPending >= _batchSize) submit(f);
+}
+
+void BatchFileWriter::submit(File& f) noexcept
+{
+    Batch b{ f.fd, std::move(f.pending) };
+    f.pending.clear();
+    f.nPending = 0;
+    if (!_thread.joinable())
+    {
+        writeBatch(b);
+        return;
+    }
+    std::unique_lock<std::mutex> lock(_queueMutex);
+    _queueNotFull.wait(lock, [this] { return _queue.size() < _maxQueued; });
+    _queue.push_back(std::move(b));
+    _queueChanged.notify_all();
+}
+
+void BatchFileWriter::writeBatch(Batch& b, const char* data, std::size_t n) noexcept
+{
+#ifdef _WIN32
+    auto writeAll = [this, &b](const char* p, std::size_t size)
+    {
+        while (size && !_error)
+        {
+            auto k = _write(b.fd, p, (unsigned)std::min<std::size_t>(size, 0x40000000));
+            if (k <= 0) _error = true;
+            else { p += k; size -= k; }
+        }
+    };
+    for (auto& c : b.chunks) writeAll(c.data, c.size);
+    writeAll(data, n);
+#else
+    std::vector<iovec> iov;
+    iov.reserve(b.chunks.size() + 1);
+    for (auto& c : b.chunks) iov.push_back(iovec{ c.data, c.size });
+    if (n) iov.push_back(iovec{ const_cast<char*>(data), n });
+
+    std::size_t i = 0;
+    while (i != iov.size())
+    {
+        auto r = ::writev(b.fd, &iov[i], (int)std::min<std::size_t>(iov.size() - i, IOV_MAX));
+        if (r < 0)
+        {
+            if (errno == EINTR) continue;
+            _error = true;
+            break;
+        }
+        for (auto k = (std::size_t)r; k; ) // skip what is written, maybe partially
+        {
+            if (k >= iov[i].iov_len) k -= iov[i++].iov_len;
+            else
+            {
+                iov[i].iov_base = static_cast<char*>(iov[i].iov_base) + k;
+                iov[i].iov_len -= k;
+                k = 0;
+            }
+        }
+    }
+#endif
+    std::lock_guard<std::mutex> lock(_poolMutex);
+    for (auto& c : b.chunks) _pool.push_back(c.data);
+}
+
+bool BatchFileWriter::flush() noexcept
+{
+    for (auto& f : _files)
+    {
+        if (f.nPending) submit(f);
+    }
+    if (_thread.joinable())
+    {
+        std::unique_lock<std::mutex> lock(_queueMutex);
+        _queueChanged.wait(lock, [this] { return _queue.empty() && !_busy; });
+    }
+    return !_error;
+}
+
+void BatchFileWriter::run() noexcept
+{
+    std::unique_lock<std::mutex> lock(_queueMutex);
+    for (;;)
+    {
+        _queueChanged.wait(lock, [this] { return _stop || !_queue.empty(); });
+        if (_queue.empty()) return; // stopped
+        auto b = std::move(_queue.front());
+        _queue.pop_front();
+        _busy = true;
+        _queueNotFull.notify_one();
+        lock.unlock();
+        writeBatch(b);
+        lock.lock();
+        _busy = false;
+        _queueChanged.notify_all();
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "processor.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/// IWriter to many files which batches small writes per file.
+/// \detail Data is copied into fixed-size blocks taken from a pool shared by
+/// all files, so that an open file costs only a descriptor and the blocks it
+/// has pending. When a file gathers the batch size, its blocks are written
+/// with one vectored write (writev). Optionally, the writes are done by a
+/// background thread fed through a bounded queue.
+class BatchFileWriter: public XmlParser::IWriter
+{
+    public:
+
+    static const std::size_t default_batch_size = 0x10000;
+    static const std::size_t default_block_size = 0x4000;
+
+    /// Constructor.
+    ///\ param batchSize Size of data a file gathers before it is written.
+    ///\ param blockSize Size of pool blocks.
+    BatchFileWriter(std::size_t batchSize = default_batch_size,
+        std::size_t blockSize = default_block_size) noexcept;
+
+    /// Destructor. Flushes and closes all files, stops the thread.
+    ~BatchFileWriter();
+
+    /// Creates a file; its userIndex is the number of files opened before.
+    /// \return True if opened succesfully, false otherwise
+    bool openFile(const char* path) noexcept;
+
+    /// Same as openFile() for each path; on failure, all files are closed.
+    bool openFiles(std::initializer_list<const char*> paths) noexcept;
+
+    /// Number of opened files.
+    std::size_t size() const noexcept { return _files.size(); }
+
+    /// Makes writes to be done by a background thread.
+    ///\ param maxQueued Number of batches waiting to be written; write()
+    /// blocks when the queue is full.
+    void startThread(std::size_t maxQueued = 64) noexcept;
+
+    /// IWriter implementation.
+    ///\ param userIndex Index of the file.
+    virtual void write(const char* data, std::size_t n, std::size_t userIndex) noexcept;
+    using IWriter::write;
+
+    /// Writes all pending data and waits until it is done.
+    /// \return False if any write failed.
+    bool flush() noexcept;
+
+    /// Flushes, stops the thread and closes all files.
+    void closeFiles() noexcept;
+
+    /// True if any write failed.
+    bool error() const noexcept { return _error; }
+
+    private:
+
+    struct Chunk
+    {
+        char* data;
+        std::size_t size;
+    };
+
+    struct File
+    {
+        int fd;
+        std::vector<Chunk> pending;
+        std::size_t nPending;
+    };
+
+    struct Batch
+    {
+        int fd;
+        std::vector<Chunk> chunks;
+    };
+
+    std::size_t _batchSize;
+    std::size_t _blockSize;
+    std::vector<File> _files;
+    std::atomic<bool> _error;
+
+    std::mutex _poolMutex;
+    std::vector<char*> _pool;  // free blocks
+    std::vector<char*> _blocks;  // all blocks
+
+    std::thread _thread;
+    std::mutex _queueMutex;
+    std::condition_variable _queueNotFull;
+    std::condition_variable _queueChanged;
+    std::deque<Batch> _queue;
+    std::size_t _maxQueued;
+    bool _busy;
+    bool _stop;
+
+    char* allocBlock() noexcept;
+    void submit(File& f) noexcept;
+    void writeBatch(Batch& b, const char* data = 0, std::size_t n = 0) noexcept;
+    void run() noexcept;
+    void stopThread() noexcept;
+};
@@ -4,6 +4,7 @@
 #include <string>
 #include <string_view>
 #include <functional>
+#include "simd.h"
 
 namespace char_parsers
 {
@@ -101,11 +102,10 @@ struct any_of
 	const T* end;
 
 	template<bool IsCharT = false>
-	constexpr static bool check(UChar c, T t) noexcept {return (t(c));}
-	template<>
-	constexpr static bool check<true>(UChar c, T t) noexcept 
-	{ 
-		return (c == static_cast<std::make_unsigned_t<T> >(t));
+	constexpr static bool check(UChar c, T t) noexcept 
+	{
+		if constexpr (IsCharT) return (c == static_cast<std::make_unsigned_t<T> >(t));
+		else return (t(c));
 	}
 
 };
@@ -122,7 +122,7 @@ struct all_of: any_of<T>
 	{
 		for (const T* p = any_of<T>::begin; p != any_of<T>::end; ++p)
 		{
-			if (!any_of<T>::check<std::is_integral_v<T> >
+			if (!any_of<T>::template check<std::is_integral_v<T> >
 				(static_cast<std::make_unsigned_t<CharT>>(c),	*p)) return false;
 		}
 		return true;
@@ -140,7 +140,7 @@ struct not_of : any_of<T>
 	{
 		for (const T* p = any_of<T>::begin; p != any_of<T>::end; ++p)
 		{
-			if (any_of<T>::check<std::is_integral_v<T> >
+			if (any_of<T>::template check<std::is_integral_v<T> >
 				(static_cast<std::make_unsigned_t<CharT>>(c),	*p)) return false;
 		}
 		return true;
@@ -354,14 +354,25 @@ public:
 
 	bool seek(stl_string_view s, bool skipFound = false) noexcept
 	{
-		do {
-			if (skip_if(s))
-			{
-				if (!skipFound) _p1 -= s.size();
-				return true;
-			}	
-		} while (skip());
-		return false;
+		const char_type* p;
+		if constexpr (sizeof(char_type) == 1)
+		{
+			auto b = reinterpret_cast<const char*>(_p1);
+			auto e = reinterpret_cast<const char*>(_p2);
+			p = _p1 + (simd::find_string(b, e, reinterpret_cast<const char*>(s.data()), s.size()) - b);
+		}
+		else
+		{
+			auto i = stl_string_view(_p1, size()).find(s);
+			p = i != stl_string_view::npos ? _p1 + i : _p2;
+		}
+		if (p == _p2 && !s.empty())
+		{
+			_p1 = _p2;
+			return false;
+		}
+		_p1 = skipFound ? p + s.size() : p;
+		return true;
 	}
 
 	
@@ -472,6 +483,11 @@ public:
 
 	std::size_t length() const noexcept
 	{
+		if constexpr (sizeof(char_type) == 1)
+		{
+			return simd::count_utf8(reinterpret_cast<const char*>(_p1), 
+				reinterpret_cast<const char*>(_p2));
+		}
 		std::size_t n = 0;
 		std::size_t ncp = size();
 		for (const char_type* p = _p1; ncp; --ncp)
@@ -492,17 +508,51 @@ public:
 
 	bool skip(std::size_t n = 1) noexcept
 	{
-		std::size_t ncp = size();
-		while (ncp)
+		while (n && !empty())
 		{
-			if (!is_trailing(*_p1))
+			if constexpr (sizeof(char_type) == 1) // ASCII runs at once
 			{
-				if(--n == (std::size_t) - 1) return true;
+				auto p = reinterpret_cast<const char*>(_p1);
+				auto k = simd::find_non_ascii(p, p + std::min(size(), n)) - p;
+				_p1 += k;
+				n -= k;
+				if (!n || empty()) break;
 			}
-			++_p1;
-			--ncp;
+			// a stray continuation byte is not a character
+			if (!is_trailing(*_p1++)) --n;
+			while (!empty() && is_trailing(*_p1)) ++_p1;
+		}
+		return !n;
+	}
+
+	/// Decodes up to n characters to UTF-32 and skips them; ASCII runs are
+	/// converted 16 bytes at a time.
+	/// \return Number of characters decoded.
+	std::size_t decode(char32_t* dst, std::size_t n) noexcept
+	{
+		std::size_t i = 0;
+		while (i != n && !empty())
+		{
+			if constexpr (sizeof(char_type) == 1)
+			{
+				auto p = reinterpret_cast<const char*>(_p1);
+				auto k = simd::widen_ascii(p, p + std::min(size(), n - i), dst + i);
+				_p1 += k;
+				i += k;
+				if (i == n || empty()) break;
+			}
+			auto c = getc();
+			if (c) dst[i++] = c;
 		}
-		return --n == (std::size_t) -1;
+		return i;
+	}
+
+	/// The first n characters, or all if there are less.
+	stl_string_view head(std::size_t n) const noexcept
+	{
+		charser_base_UTF8<char_type> it(*this);
+		it.skip(n);
+		return stl_string_view(_p1, it._p1 - _p1);
 	}
 
 	UChar peek() const noexcept
@@ -522,7 +572,8 @@ public:
 			if (c < 0x80) return c;
 			if (c < 0xC0) // extra trailing codes; ignore and skip 
 			{
-				do { ++_p1; } while (--ncp && is_trailing(*_p1));
+				while (_p1 != _p2 && is_trailing(*_p1)) ++_p1;
+				return getc();
 			}
 			if (c < 0xE0) // 2 bytes
 			{
@@ -811,7 +862,7 @@ public:
 	/// \brief True if size != 0
 	
 	/// \fn std::size_t length() const noexcept
-	/// \brief Sequence length, in characters
+	/// \brief Sequence length, in characters; UTF-8 is counted 16 bytes at a time
 
 	/// \fn const char_type* begin() const noexcept
 	/// \brief The left physical bound of the sequence.
@@ -837,6 +888,13 @@ public:
 	/// \fn bool skip(std::size_t n = 1) noexcept
 	///\brief Increments the pointer
 	///\return False if the end of text has been reached
+
+	/// \fn std::size_t decode(char32_t* dst, std::size_t n) noexcept
+	///\brief UTF-8 only: decodes up to n characters to dst and increments the pointer
+	///\return Number of characters decoded
+
+	/// \fn stl_string_view head(std::size_t n) const noexcept
+	///\brief UTF-8 only: the first n characters, e.g. to cut a value to a length
 	
 	/// \fn UChar peek() const noexcept 
 	///\brief Gets current char without increment
@@ -1257,10 +1315,10 @@ class chunk_charser : protected charser_base_A<char>
 		auto p = s.data();
 		std::size_t nLeft = s.size();
 		do {
-			auto n = base_type::skip(stl_string_view{ p, nLeft });
+			auto n = base_type::skip_while(stl_string_view{ p, nLeft });
 			p += n;
 			nLeft -= n;
-		} while (nLeft || (empty() && reload()));
+		} while (nLeft && empty() && reload());
 		return !nLeft;
 	}
 
@@ -1339,7 +1397,7 @@ class chunk_charser : protected charser_base_A<char>
 	template<typename A>
 	constexpr UChar getline(stl_string<A>& dst, predicate q = '\n') noexcept
 	{
-		dst.clear(); return seek_append(q, true.dst, false);
+		dst.clear(); return seek_append(q, true, dst, false);
 	}
 
 
@@ -1351,12 +1409,11 @@ class chunk_charser : protected charser_base_A<char>
 		auto p = s.data();
 		auto nLeft = s.size();
         do {
-            auto p = get();
 			auto n = base_type::skip_while(stl_string_view{ p, nLeft });
             dst.append(p, n);
             p += n;
             nLeft -= n;
-        } while (nLeft || (empty() && reload()));
+        } while (nLeft && empty() && reload());
         return !nLeft;
     }
 
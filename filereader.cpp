@@ -0,0 +1,334 @@
+#include "filereader.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // with kAdaptive, reads faster than this make the next read bigger, reads
+    // slower than 4 times this make it smaller
+    const auto fast_read_time = std::chrono::microseconds(500);
+
+    // with kSequential, cached pages behind the position are dropped by this size
+    const std::uint64_t drop_size = 0x800000;
+
+    std::size_t roundUp(std::size_t n, std::size_t gran) noexcept
+    {
+        return (std::max<std::size_t>(n, 1) + gran - 1) / gran * gran;
+    }
+
+#ifndef _WIN32
+    std::size_t preadAll(int fd, char* p, std::size_t n, std::uint64_t pos) noexcept
+    {
+        std::size_t nRead = 0;
+        while (nRead != n)
+        {
+            auto r = pread(fd, p + nRead, n - nRead, pos + nRead);
+            if (r > 0) nRead += r;
+            else if (r == 0) break;
+            else if (errno != EINTR) return 0;
+        }
+        return nRead;
+    }
+#endif
+}
+
+FileReader::FileReader(std::size_t capacity, std::pmr::memory_resource* resource) noexcept :
+    _resource(resource),
+    _buffer(0),
+    _capacity(0),
+    _requested(capacity),
+    _hugePages(false),
+    _policy(Policy::kDefault),
+    _readSize(0),
+    _pos(0),
+    _size(0),
+    _dropped(0),
+    _error(false),
+    _direct(false),
+    _skip(0),
+#ifdef _WIN32
+    _file(0)
+#else
+    _fd(-1)
+#endif
+{
+    allocate(false);
+}
+
+FileReader::~FileReader()
+{
+    close();
+    free();
+}
+
+void FileReader::allocate(bool hugePages) noexcept
+{
+    _hugePages = hugePages;
+    _capacity = roundUp(_requested, hugePages ? huge_page_size : page_size);
+    if (!hugePages)
+    {
+        try
+        {
+            _buffer = static_cast<char*>(_resource->allocate(_capacity, page_size));
+        }
+        catch (...)
+        {
+            _buffer = 0;
+            _capacity = 0;
+        }
+        return;
+    }
+#ifdef _WIN32
+    // needs SeLockMemoryPrivilege; if not granted, falls back to normal pages
+    auto large = GetLargePageMinimum();
+    if (large)
+    {
+        auto n = roundUp(_capacity, large);
+        _buffer = static_cast<char*>(VirtualAlloc(0, n,
+            MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE));
+        if (_buffer)
+        {
+            _capacity = n;
+            return;
+        }
+    }
+    _buffer = static_cast<char*>(VirtualAlloc(0, _capacity, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+#else
+    void* p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    // reserved huge pages first; if none, transparent ones
+    p = mmap(0, _capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if (p == MAP_FAILED)
+    {
+        p = mmap(0, _capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+        if (p != MAP_FAILED) madvise(p, _capacity, MADV_HUGEPAGE);
+#endif
+    }
+    _buffer = p != MAP_FAILED ? static_cast<char*>(p) : 0;
+#endif
+    if (!_buffer) _capacity = 0;
+}
+
+void FileReader::free() noexcept
+{
+    if (!_buffer) return;
+    if (!_hugePages) _resource->deallocate(_buffer, _capacity, page_size);
+#ifdef _WIN32
+    else VirtualFree(_buffer, 0, MEM_RELEASE);
+#else
+    else munmap(_buffer, _capacity);
+#endif
+    _buffer = 0;
+    _capacity = 0;
+}
+
+bool FileReader::isOpen() const noexcept
+{
+#ifdef _WIN32
+    return _file != 0;
+#else
+    return _fd != -1;
+#endif
+}
+
+bool FileReader::open(const char* path) noexcept
+{
+    close();
+    bool hugePages = (_policy & Policy::kHugePages) != 0;
+    if (hugePages != _hugePages || !_buffer)
+    {
+        free();
+        allocate(hugePages);
+    }
+    if (!_buffer) return false;
+    _pos = 0;
+    _size = 0;
+    _dropped = 0;
+    _error = false;
+    _direct = false;
+    _skip = 0;
+    _readSize = _capacity;
+    if (_policy & Policy::kAdaptive) _readSize = std::min(_capacity, min_read_size);
+    if (_policy & Policy::kFastStart) _readSize = std::min(_capacity, first_read_size);
+
+#ifdef _WIN32
+    // 'S': caching optimized for sequential access; kDirect would need unbuffered 
+    // handles, so it is taken as kSequential
+    _file = fopen(path, (_policy & (Policy::kSequential | Policy::kDirect)) ? "rbS" : "rb");
+    if (_file && setvbuf(_file, nullptr, _IONBF, 0) == 0) 
+    {
+        struct _stat64 st;
+        if (_fstat64(_fileno(_file), &st) == 0 && (st.st_mode & _S_IFREG)) _size = st.st_size;
+        if (_size && _size <= _capacity) _readSize = _capacity;
+        return true;
+    }
+    if (_file) fclose(_file);
+    _file = 0;
+    return false;
+#else
+#ifdef O_DIRECT
+    if (_policy & Policy::kDirect)
+    {
+        // some file systems (e.g. tmpfs) refuse O_DIRECT; then the file is read as usual
+        _fd = ::open(path, O_RDONLY | O_CLOEXEC | O_DIRECT);
+        _direct = _fd != -1;
+    }
+#endif
+    if (_fd == -1) _fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (_fd == -1) return false;
+    struct stat st;
+    if (fstat(_fd, &st) == 0 && S_ISREG(st.st_mode)) _size = st.st_size;
+    if (_size && _size <= _capacity) _readSize = _capacity; // one read for small files
+#if !defined(O_DIRECT) && defined(F_NOCACHE)
+    if (_policy & Policy::kDirect) fcntl(_fd, F_NOCACHE, 1);
+#endif
+#ifdef POSIX_FADV_SEQUENTIAL
+    if (_policy & Policy::kSequential)
+    {
+        posix_fadvise(_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        posix_fadvise(_fd, 0, 0, POSIX_FADV_NOREUSE);
+    }
+#endif
+    return true;
+#endif
+}
+
+void FileReader::close() noexcept
+{
+#ifdef _WIN32
+    if (_file) fclose(_file);
+    _file = 0;
+#else
+    if (_fd != -1) ::close(_fd);
+    _fd = -1;
+#endif
+}
+
+std::size_t FileReader::readAll(char* p, std::size_t n) noexcept
+{
+#ifdef _WIN32
+    auto nRead = _fread_nolock(p, 1, n, _file);
+    if (ferror(_file)) _error = true;
+    return nRead;
+#else
+    std::size_t nRead = 0;
+    while (nRead != n)
+    {
+        auto r = ::read(_fd, p + nRead, n - nRead);
+        if (r > 0) nRead += r;
+        else if (r == 0) break;
+        else if (errno == EINVAL && _direct) dropDirect();  // unaligned, e.g. after a short read
+        else if (errno != EINTR)
+        {
+            _error = true;
+            break;
+        }
+    }
+    return nRead;
+#endif
+}
+
+void FileReader::dropDirect() noexcept
+{
+    // reads the rest through the cache; with O_DIRECT, the unaligned tail of the file
+    // may not be readable on some systems
+#if !defined(_WIN32) && defined(O_DIRECT)
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) & ~O_DIRECT);
+#endif
+    _direct = false;
+}
+
+std::size_t FileReader::read() noexcept
+{
+    if (!isOpen() || _error) return 0;
+    if (_size && _size <= _capacity && _pos >= _size && !_skip) return 0;  // saves a read() returning 0
+    auto n = std::min(_readSize, _capacity);
+    auto t0 = std::chrono::steady_clock::now();
+    auto nRead = readAll(_buffer, n);
+    _pos += nRead;
+    if (_skip)
+    {
+        auto skip = std::min(_skip, nRead);
+        memmove(_buffer, _buffer + skip, nRead - skip);
+        nRead -= skip;
+        _skip = 0;
+    }
+
+    if (_policy & Policy::kAdaptive)
+    {
+        auto t = std::chrono::steady_clock::now() - t0;
+        if (nRead == n && t < fast_read_time) _readSize = std::min(_capacity, n * 2);
+        else if (t > fast_read_time * 4) _readSize = std::max(std::min(_capacity, min_read_size), n / 2);
+    }
+    else _readSize = _capacity; // after the first read of kFastStart
+
+#ifdef POSIX_FADV_DONTNEED
+    if ((_policy & Policy::kSequential) && _pos - _dropped >= drop_size)
+    {
+        posix_fadvise(_fd, _dropped, _pos - _dropped, POSIX_FADV_DONTNEED);
+        _dropped = _pos;
+    }
+#endif
+    return nRead;
+}
+
+bool FileReader::seek(std::uint64_t pos) noexcept
+{
+    if (!isOpen()) return false;
+    // with O_DIRECT, reading starts at the aligned position below
+    _skip = _direct ? pos % direct_align : 0;
+    pos -= _skip;
+#ifdef _WIN32
+    bool ok = _fseeki64(_file, pos, SEEK_SET) == 0;
+#else
+    bool ok = lseek(_fd, pos, SEEK_SET) != -1;
+#endif
+    if (!ok) _error = true;
+    else _pos = _dropped = pos;
+    return ok;
+}
+
+std::size_t FileReader::readAt(std::uint64_t pos, char* dst, std::size_t n) const noexcept
+{
+    if (!isOpen()) return 0;
+#ifdef _WIN32
+    // the handle has one position, that of read(), which is restored
+    auto cur = _ftelli64(_file);
+    if (cur < 0 || _fseeki64(_file, pos, SEEK_SET) != 0) return 0;
+    auto nRead = fread(dst, 1, n, _file);
+    if (_fseeki64(_file, cur, SEEK_SET) != 0) return 0;
+    return nRead;
+#else
+    auto isAligned = [](std::uint64_t v) { return v % direct_align == 0; };
+    if (!_direct || (isAligned(pos) && isAligned(n) && isAligned(reinterpret_cast<std::uintptr_t>(dst))))
+    {
+        return preadAll(_fd, dst, n, pos);
+    }
+    // O_DIRECT needs aligned offsets, sizes and buffers; reads the blocks around the data
+    auto head = pos % direct_align;
+    auto size = roundUp(head + n, direct_align);
+    void* blocks = 0;
+    if (posix_memalign(&blocks, direct_align, size) != 0) return 0;
+    auto nRead = preadAll(_fd, static_cast<char*>(blocks), size, pos - head);
+    n = nRead > head ? std::min(n, nRead - head) : 0;
+    memcpy(dst, static_cast<char*>(blocks) + head, n);
+    std::free(blocks);
+    return n;
+#endif
+}
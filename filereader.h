@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory_resource>
+
+/// Reads a file sequentially, chunk by chunk, into a page-aligned buffer
+/// allocated from a memory resource, or mapped by the system for huge pages;
+/// the reading and the buffer are tuned by policies.
+class FileReader
+{
+    public:
+
+    static constexpr std::size_t page_size = 0x1000;
+    static constexpr std::size_t huge_page_size = 0x200000;
+    static constexpr std::size_t first_read_size = 0x1000;  // with Policy::kFastStart
+    static constexpr std::size_t min_read_size = 0x10000;   // with Policy::kAdaptive
+    static constexpr std::size_t direct_align = 0x1000;     // of offsets and sizes with Policy::kDirect
+
+    /// Reading policies; combinations of the flags.
+    struct Policy
+    {
+        enum
+        {
+            kHugePages = 1,   /// Back the buffer by 2 MB pages, if the system allows
+            kSequential = 2,  /// Advise the system of a one-time sequential read
+            kAdaptive = 4,    /// Start with small reads, growing while reads are fast
+            kFastStart = 8,   /// Make the first read small, for the first item to come early
+            kDirect = 16,     /// Bypass the system cache (O_DIRECT), if the file system allows
+            kDefault = 0
+        };
+    };
+
+    /// Constructor. Allocates the buffer.
+    ///\ param capacity Size of the buffer, rounded up to page_size; with
+    /// kHugePages, to huge_page_size.
+    ///\ param resource Memory resource of the buffer, aligned by page_size;
+    /// not used with kHugePages, whose pages only the system can give.
+    FileReader(std::size_t capacity, 
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) noexcept;
+    FileReader(const FileReader&) = delete;
+    FileReader& operator=(const FileReader&) = delete;
+
+    /// Destructor. Closes the file and frees the buffer.
+    ~FileReader();
+
+    /// Get and set the policies; they take effect at the next open().
+    int getPolicy() const noexcept { return _policy; }
+    void setPolicy(int v) noexcept { _policy = v; }
+
+    /// Opens a file. A previous file will be closed. A file which fits in 
+    /// the buffer is read at once by the first read(), whatever the policies.
+    /// \return True if opened succesfully, false otherwise.
+    bool open(const char* path) noexcept;
+
+    /// Size of the file as of open(); 0 if unknown, e.g. for pipes.
+    std::uint64_t size() const noexcept { return _size; }
+
+    /// Closes the file.
+    void close() noexcept;
+
+    /// True if a file is open.
+    bool isOpen() const noexcept;
+
+    /// Reads the next chunk of the file to data().
+    /// \return Number of bytes read; 0 at the end of file or on error.
+    std::size_t read() noexcept;
+
+    /// Sets the position of the next read.
+    bool seek(std::uint64_t pos) noexcept;
+
+    /// Reads data at a position into a buffer of the caller, without changing
+    /// the position or the data of read(). On POSIX systems, threads may call
+    /// it at once, e.g. each for a part of the file given by an index; on 
+    /// Windows, it must not be called while read() runs. With kDirect, the 
+    /// data bypasses the cache as well; pos, n and dst aligned by direct_align
+    /// save a copy.
+    /// \return Number of bytes read; less at the end of file, 0 on error.
+    std::size_t readAt(std::uint64_t pos, char* dst, std::size_t n) const noexcept;
+
+    /// True if a read or seek failed.
+    bool error() const noexcept { return _error; }
+
+    /// The buffer; valid until the next open().
+    char* data() const noexcept { return _buffer; }
+
+    /// Size of the buffer.
+    std::size_t capacity() const noexcept { return _capacity; }
+
+    private:
+
+    std::pmr::memory_resource* _resource;
+    char* _buffer;
+    std::size_t _capacity;
+    std::size_t _requested;  // capacity as given to the constructor
+    bool _hugePages;         // the buffer is mapped for kHugePages, not from _resource
+    int _policy;
+    std::size_t _readSize;   // size of the next read
+    std::uint64_t _pos;      // file position
+    std::uint64_t _size;     // file size; 0 if unknown
+    std::uint64_t _dropped;  // pages before this position are dropped from the cache
+    bool _error;
+    bool _direct;            // the file is read bypassing the cache
+    std::size_t _skip;       // bytes of the next read to drop, after an unaligned seek
+#ifdef _WIN32
+    FILE* _file;
+#else
+    int _fd;
+#endif
+
+    void allocate(bool hugePages) noexcept;
+    void free() noexcept;
+    std::size_t readAll(char* p, std::size_t n) noexcept;
+    void dropDirect() noexcept;
+};
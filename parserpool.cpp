@@ -0,0 +1,118 @@
+#include "parserpool.h"
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <thread>
+
+XmlParserPool::XmlParserPool(std::size_t bufferSize, std::pmr::memory_resource* resource) noexcept :
+    _bufferSize(bufferSize),
+    _resource(resource),
+    _options(XmlParser::Options::kDefault),
+    _skipMask(0),
+    _readPolicy(FileReader::Policy::kDefault)
+{
+}
+
+XmlParser* XmlParserPool::acquire() noexcept
+{
+    XmlParser* p = 0;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_free.empty())
+        {
+            p = _free.back();
+            _free.pop_back();
+        }
+    }
+    if (!p)
+    {
+        // constructed out of the lock; the buffer allocation is the slow part
+        std::unique_ptr<XmlParser> created(new (std::nothrow) XmlParser(_bufferSize, _resource));
+        if (!created) return 0;
+        p = created.get();
+        std::lock_guard<std::mutex> lock(_mutex);
+        _parsers.push_back(std::move(created));
+        _free.reserve(_parsers.size());  // release() does not allocate then
+    }
+    p->setOptions(_options);
+    p->setSkipMask(_skipMask);
+    p->setReadPolicy(_readPolicy);
+    p->setLimits(_limits);
+    p->clearElementFilter();
+    for (auto& name : _filterNames) p->addElementFilter(name);
+    return p;
+}
+
+void XmlParserPool::release(XmlParser* parser) noexcept
+{
+    parser->closeFile();
+    std::lock_guard<std::mutex> lock(_mutex);
+    _free.push_back(parser);
+}
+
+std::size_t XmlParserPool::size() const noexcept
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _parsers.size();
+}
+
+XmlBatchProcessor::XmlBatchProcessor(XmlParserPool& pool, std::size_t nThreads) noexcept :
+    _pool(pool),
+    _nThreads(1),
+    _nErrors(0)
+{
+    setThreadCount(nThreads);
+}
+
+void XmlBatchProcessor::setThreadCount(std::size_t v) noexcept
+{
+    if (!v) v = std::thread::hardware_concurrency();
+    _nThreads = std::max<std::size_t>(v, 1);
+}
+
+bool XmlBatchProcessor::run(std::size_t n, const std::function<bool(XmlParser&, std::size_t)>& open,
+    const Process& process) noexcept
+{
+    // documents are taken one by one from a shared counter, so that big
+    // ones do not hold up others
+    std::atomic<std::size_t> iNext(0), nErrors(0);
+    auto work = [&]()
+    {
+        XmlParserPool::Lease parser(_pool);
+        for (std::size_t i; (i = iNext++) < n; )
+        {
+            if (!parser || !open(*parser, i))
+            {
+                ++nErrors;
+                continue;
+            }
+            process(i, *parser);
+            if (parser->error()) ++nErrors;
+            parser->closeFile();
+        }
+    };
+    auto nThreads = std::min(_nThreads, n);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 1; t < nThreads; ++t) threads.emplace_back(work);
+    work(); // this thread is one of them
+    for (auto& t : threads) t.join();
+    _nErrors = nErrors;
+    return !_nErrors;
+}
+
+bool XmlBatchProcessor::processFiles(const std::vector<std::string>& paths, const Process& process) noexcept
+{
+    return run(paths.size(), [&paths](XmlParser& p, std::size_t i)
+    {
+        return p.openFile(paths[i].c_str());
+    }, process);
+}
+
+bool XmlBatchProcessor::processBuffers(const std::vector<std::string_view>& buffers,
+    const Process& process) noexcept
+{
+    return run(buffers.size(), [&buffers](XmlParser& p, std::size_t i)
+    {
+        return p.openBuffer(buffers[i].data(), buffers[i].size());
+    }, process);
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "processor.h"
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// Pool of parsers, for processing many small documents without
+/// constructing a parser, with its file buffer, text and path storage,
+/// for each of them.
+class XmlParserPool
+{
+    public:
+
+    /// Constructor.
+    ///\ param bufferSize Size of parsers' file buffers; documents which fit
+    /// in it are read at once.
+    ///\ param resource Memory resource of parsers; must be thread-safe if
+    /// parsers are used by many threads.
+    XmlParserPool(std::size_t bufferSize = XmlParser::default_chunk_size,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) noexcept;
+
+    /// Get and set options, skip masks, read policies and limits given to 
+    /// parsers by acquire().
+    int getOptions() const noexcept { return _options; }
+    void setOptions(int v) noexcept { _options = v; }
+    int getSkipMask() const noexcept { return _skipMask; }
+    void setSkipMask(int v) noexcept { _skipMask = v; }
+    int getReadPolicy() const noexcept { return _readPolicy; }
+    void setReadPolicy(int v) noexcept { _readPolicy = v; }
+    const XmlParser::Limits& getLimits() const noexcept { return _limits; }
+    void setLimits(const XmlParser::Limits& v) noexcept { _limits = v; }
+
+    /// Element filter given to parsers by acquire(); see XmlParser::addElementFilter().
+    void addElementFilter(std::string_view name) { _filterNames.emplace_back(name); }
+    void clearElementFilter() noexcept { _filterNames.clear(); }
+
+    /// Takes a free parser, or creates a new one; thread-safe.
+    /// \return Null if out of memory.
+    XmlParser* acquire() noexcept;
+
+    /// Closes the parser's file and returns it to the pool; thread-safe.
+    void release(XmlParser* parser) noexcept;
+
+    /// Number of parsers created.
+    std::size_t size() const noexcept;
+
+    /// Parser taken from a pool for the lifetime of the object.
+    class Lease
+    {
+        public:
+        Lease(XmlParserPool& pool) noexcept: _pool(pool), _parser(pool.acquire()) {}
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease() { if (_parser) _pool.release(_parser); }
+        explicit operator bool() const noexcept { return _parser != 0; }
+        XmlParser& operator*() const noexcept { return *_parser; }
+        XmlParser* operator->() const noexcept { return _parser; }
+        private:
+        XmlParserPool& _pool;
+        XmlParser* _parser;
+    };
+
+    private:
+
+    std::size_t _bufferSize;
+    std::pmr::memory_resource* _resource;
+    int _options;
+    int _skipMask;
+    int _readPolicy;
+    XmlParser::Limits _limits;
+    std::vector<std::string> _filterNames;
+    mutable std::mutex _mutex;
+    std::vector<std::unique_ptr<XmlParser> > _parsers;  // all created
+    std::vector<XmlParser*> _free;
+};
+
+/// Processes lists of documents, each by a parser of a pool, by a number
+/// of threads.
+///
+///     XmlParserPool pool(0x10000);
+///     XmlBatchProcessor batch(pool);
+///     batch.processFiles(paths, [&](std::size_t i, XmlParser& p)
+///     {
+///         while (p.next()) ...
+///     });
+class XmlBatchProcessor
+{
+    public:
+
+    /// Called for each document with its index in the list and a parser
+    /// opened on it; called by many threads at once.
+    using Process = std::function<void(std::size_t, XmlParser&)>;
+
+    /// Constructor.
+    ///\ param nThreads Number of threads; 0 means one per core.
+    XmlBatchProcessor(XmlParserPool& pool, std::size_t nThreads = 0) noexcept;
+
+    /// Gets and sets the number of threads.
+    std::size_t getThreadCount() const noexcept { return _nThreads; }
+    void setThreadCount(std::size_t v) noexcept;
+
+    /// Processes files.
+    /// \return False if any file could not be opened or had a data error
+    /// (see getErrorCount()).
+    bool processFiles(const std::vector<std::string>& paths, const Process& process) noexcept;
+
+    /// Processes documents in memory.
+    /// \return False if any document had a data error.
+    bool processBuffers(const std::vector<std::string_view>& buffers, const Process& process) noexcept;
+
+    /// Number of documents which failed in the last call.
+    std::size_t getErrorCount() const noexcept { return _nErrors; }
+
+    private:
+
+    XmlParserPool& _pool;
+    std::size_t _nThreads;
+    std::size_t _nErrors;
+
+    bool run(std::size_t n, const std::function<bool(XmlParser&, std::size_t)>& open,
+        const Process& process) noexcept;
+};
@@ -0,0 +1,200 @@
+#include "pipeline.h"
+
+XmlRecordPipeline::XmlRecordPipeline(std::size_t nThreads, std::size_t bufferSize) noexcept :
+    _parser(bufferSize),
+    _level(2),
+    _nThreads(1),
+    _window(0),
+    _options(0),
+    _nRecords(0),
+    _nQueued(0),
+    _stop(false)
+{
+    setThreadCount(nThreads);
+}
+
+XmlRecordPipeline::~XmlRecordPipeline()
+{
+}
+
+void XmlRecordPipeline::setThreadCount(std::size_t v) noexcept
+{
+    if (!v) v = std::thread::hardware_concurrency();
+    _nThreads = std::max<std::size_t>(v, 1);
+}
+
+void XmlRecordPipeline::write(const char* data, std::size_t n, std::size_t slot) noexcept
+{
+    _slots[slot].data.append(data, n);
+}
+
+bool XmlRecordPipeline::isRecord() const noexcept
+{
+    return _parser.isElement() && (!_level || _parser.getLevel() == _level) &&
+        (_name.empty() || _parser.getName() == _name);
+}
+
+void XmlRecordPipeline::getScope(std::shared_ptr<const XmlParser::Scope>& scope,
+    std::string& ancestors) noexcept
+{
+    // entities are declared before the root, so the scope changes only with
+    // the start-tags around the record
+    std::string_view tags;
+    auto& path = _parser.getPath();
+    auto level = _parser.getLevel();
+    if (level > 1) tags = std::string_view(path[1].data(), path[level - 1].data() + path[level - 1].size() - path[1].data());
+    if (scope && tags == ancestors) return;
+    ancestors.assign(tags);
+    auto next = std::make_shared<XmlParser::Scope>();
+    _parser.getScope(*next);
+    if (!scope || !(*next == *scope)) scope = std::move(next);
+}
+
+void XmlRecordPipeline::push(std::size_t slot, std::size_t iWorker) noexcept
+{
+    // counted before it is visible: a worker taking it at once must not bring
+    // the count below zero; one seeing the count first only retries take()
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex); // not to miss a waiting worker
+        ++_nQueued;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_workers[iWorker]->mutex);
+        _workers[iWorker]->tasks.push_back(slot);
+    }
+    _queueCv.notify_one();
+}
+
+bool XmlRecordPipeline::take(std::size_t iWorker, std::size_t& slot) noexcept
+{
+    // own tasks are taken from the front, i.e. in order; others' from the back
+    auto n = _workers.size();
+    for (std::size_t i = 0; i != n; ++i)
+    {
+        auto& w = *_workers[(iWorker + i) % n];
+        std::lock_guard<std::mutex> lock(w.mutex);
+        if (w.tasks.empty()) continue;
+        if (i == 0)
+        {
+            slot = w.tasks.front();
+            w.tasks.pop_front();
+        }
+        else
+        {
+            slot = w.tasks.back();
+            w.tasks.pop_back();
+        }
+        --_nQueued;
+        return true;
+    }
+    return false;
+}
+
+void XmlRecordPipeline::work(std::size_t iWorker) noexcept
+{
+    auto& parser = _workers[iWorker]->parser;
+    parser.setOptions(_options);
+    for (;;)
+    {
+        std::size_t slot;
+        if (!take(iWorker, slot))
+        {
+            std::unique_lock<std::mutex> lock(_queueMutex);
+            _queueCv.wait(lock, [this] { return _nQueued || _stop; });
+            if (!_nQueued && _stop) return;
+            continue;
+        }
+        auto& s = _slots[slot];
+        parser.openBuffer(s.data.data(), s.data.size(), *s.scope);
+        process(slot, parser);
+        parser.closeFile();
+        {
+            std::lock_guard<std::mutex> lock(_doneMutex);
+            s.done = true;
+        }
+        _doneCv.notify_one();
+    }
+}
+
+void XmlRecordPipeline::wait(std::size_t slot) noexcept
+{
+    auto& s = _slots[slot];
+    if (s.done) return;
+    std::unique_lock<std::mutex> lock(_doneMutex);
+    _doneCv.wait(lock, [&s] { return s.done.load(); });
+}
+
+bool XmlRecordPipeline::run(const char* input) noexcept
+{
+    _nRecords = 0;
+    if (!_level && _name.empty()) return false;
+    if (!_parser.openFile(input)) return false;
+
+    auto nSlots = _window ? _window : _nThreads * default_slots_per_thread;
+    _slots.reset(new Slot[nSlots]);
+    for (std::size_t i = 0; i != nSlots; ++i) _slots[i].done = false;
+    prepare(nSlots);
+
+    _stop = false;
+    _nQueued = 0;
+    _workers.clear();
+    for (std::size_t i = 0; i != _nThreads; ++i) _workers.emplace_back(new Worker());
+    for (std::size_t i = 0; i != _nThreads; ++i)
+    {
+        _workers[i]->thread = std::thread(&XmlRecordPipeline::work, this, i);
+    }
+
+    // records [iEmit, _nRecords) are in the slots, in order
+
+    std::size_t iEmit = 0;
+    auto emitNext = [&]()
+    {
+        auto slot = iEmit++ % nSlots;
+        emit(slot);
+        _slots[slot].done = false;
+        _slots[slot].data.clear();
+        _slots[slot].scope.reset();
+    };
+
+    std::shared_ptr<const XmlParser::Scope> scope;
+    std::string ancestors;  // start-tags around the record which scope is of
+
+    bool ok = true;
+    while (_parser.next())
+    {
+        if (!isRecord()) continue;
+        if (_nRecords - iEmit == nSlots)
+        {
+            wait(iEmit % nSlots);
+            emitNext();
+        }
+        auto slot = _nRecords % nSlots;
+        getScope(scope, ancestors);
+        _slots[slot].scope = scope;
+        if (!_parser.copyElement(*this, slot))
+        {
+            ok = false;
+            break;
+        }
+        push(slot, _nRecords++ % _nThreads);
+        while (iEmit != _nRecords && _slots[iEmit % nSlots].done) emitNext();
+    }
+    while (iEmit != _nRecords)
+    {
+        wait(iEmit % nSlots);
+        emitNext();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        _stop = true;
+    }
+    _queueCv.notify_all();
+    for (auto& w : _workers) w->thread.join();
+    _workers.clear();
+    _slots.reset();
+
+    ok &= !_parser.error();
+    _parser.closeFile();
+    return ok;
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "processor.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/// Processes the records of a document in parallel, keeping their order.
+/// \detail The calling thread reads the document and copies each record
+/// (an element at a given level, optionally of a given name) as raw source
+/// data into a slot of a ring of a fixed size. Worker threads, each with its
+/// own queue and able to take work from the others' queues when idle, parse
+/// the slots with their own parsers. Results are handed back in source order
+/// by the calling thread; when the ring is full, reading waits for the
+/// oldest record, so that memory stays bounded however slow the processing.
+/// Anything outside records is dropped, but the namespace declarations and
+/// entities in scope of a record apply to it (see XmlParser::Scope).
+class XmlRecordPipeline: private XmlParser::IWriter
+{
+    public:
+
+    static const std::size_t default_slots_per_thread = 4;
+
+    /// Constructor.
+    ///\ param nThreads Number of worker threads; 0 means one per core.
+    ///\ param bufferSize Size of the reading parser's file buffer.
+    XmlRecordPipeline(std::size_t nThreads = 0,
+        std::size_t bufferSize = XmlParser::default_chunk_size) noexcept;
+
+    virtual ~XmlRecordPipeline();
+
+    /// Gets and sets the level of records (2 by default, i.e. the children
+    /// of the root element); 0 means any level, which requires the record
+    /// name to be set.
+    std::size_t getRecordLevel() const noexcept { return _level; }
+    void setRecordLevel(std::size_t v) noexcept { _level = v; }
+
+    /// Gets and sets the name of records; empty means any name.
+    const std::string& getRecordName() const noexcept { return _name; }
+    void setRecordName(std::string_view v) noexcept { _name = v; }
+
+    /// Gets and sets the number of worker threads.
+    std::size_t getThreadCount() const noexcept { return _nThreads; }
+    void setThreadCount(std::size_t v) noexcept;
+
+    /// Gets and sets the maximal number of records read but not handed back
+    /// yet; 0 means default_slots_per_thread per thread.
+    std::size_t getWindow() const noexcept { return _window; }
+    void setWindow(std::size_t v) noexcept { _window = v; }
+
+    /// Gets and sets options of the workers' parsers (XmlParser::Options).
+    int getOptions() const noexcept { return _options; }
+    void setOptions(int v) noexcept { _options = v; }
+
+    /// Processes a file.
+    /// \param input Full path to the file.
+    /// \return False if the file could not be opened or data error occured.
+    bool run(const char* input) noexcept;
+
+    /// Gets the reading parser's error after run().
+    XmlParser::ErrorCode getErrorCode() const noexcept { return _parser.getErrorCode(); }
+
+    /// Gets the number of records read by run().
+    std::size_t getRecordCount() const noexcept { return _nRecords; }
+
+    protected:
+
+    /// Called by worker threads for each record.
+    /// \param slot Index of the record's slot, less than the number given to prepare().
+    /// \param parser Parser opened on the record's data; the first next()
+    /// loads its start-tag.
+    virtual void process(std::size_t slot, XmlParser& parser) noexcept = 0;
+
+    /// Called by the thread of run() for each processed record, in source order.
+    virtual void emit(std::size_t slot) noexcept = 0;
+
+    /// Called by run() before processing starts, with the number of slots.
+    virtual void prepare(std::size_t) noexcept {}
+
+    private:
+
+    struct Slot
+    {
+        std::string data;
+        std::shared_ptr<const XmlParser::Scope> scope;  // shared by records with the same one
+        std::atomic<bool> done;
+    };
+
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<std::size_t> tasks;  // slots
+        XmlParser parser;
+        std::thread thread;
+    };
+
+    XmlParser _parser;
+    std::size_t _level;
+    std::string _name;
+    std::size_t _nThreads;
+    std::size_t _window;
+    int _options;
+    std::size_t _nRecords;
+
+    std::unique_ptr<Slot[]> _slots;
+    std::vector<std::unique_ptr<Worker> > _workers;
+    std::atomic<std::size_t> _nQueued;
+    bool _stop;
+    std::mutex _queueMutex;
+    std::condition_variable _queueCv;  // workers wait for tasks
+    std::mutex _doneMutex;
+    std::condition_variable _doneCv;   // run() waits for the oldest record
+
+    virtual void write(const char* data, std::size_t n, std::size_t slot) noexcept;
+    bool isRecord() const noexcept;
+    void getScope(std::shared_ptr<const XmlParser::Scope>& scope, std::string& ancestors) noexcept;
+    void push(std::size_t slot, std::size_t iWorker) noexcept;
+    bool take(std::size_t iWorker, std::size_t& slot) noexcept;
+    void work(std::size_t iWorker) noexcept;
+    void wait(std::size_t slot) noexcept;
+};
+
+/// XmlRecordPipeline which produces a result per record.
+/// \tparam Result Default-constructible result type.
+///
+///     XmlPipeline<Order> pipeline;
+///     pipeline.setRecordName("order");
+///     pipeline.run(path,
+///         [](XmlParser& p) { Order o; ...; return o; },   // worker threads
+///         [&](Order&& o) { db.insert(o); });              // in order
+template<class Result>
+class XmlPipeline: public XmlRecordPipeline
+{
+    public:
+
+    using Process = std::function<Result(XmlParser&)>;
+    using Consume = std::function<void(Result&&)>;
+
+    using XmlRecordPipeline::XmlRecordPipeline;
+
+    /// Processes a file.
+    /// \param input Full path to the file.
+    /// \param process Called by worker threads to get the result of a record.
+    /// \param consume Called by this thread with the results, in source order.
+    /// \return False if the file could not be opened or data error occured.
+    bool run(const char* input, Process process, Consume consume) noexcept
+    {
+        _process = std::move(process);
+        _consume = std::move(consume);
+        bool ok = XmlRecordPipeline::run(input);
+        _results.clear();
+        return ok;
+    }
+
+    protected:
+
+    virtual void prepare(std::size_t nSlots) noexcept { _results.assign(nSlots, Result()); }
+
+    virtual void process(std::size_t slot, XmlParser& parser) noexcept
+    {
+        _results[slot] = _process(parser);
+    }
+
+    virtual void emit(std::size_t slot) noexcept
+    {
+        _consume(std::move(_results[slot]));
+    }
+
+    private:
+
+    Process _process;
+    Consume _consume;
+    std::vector<Result> _results;
+};
@@ -1,4 +1,7 @@
 #include "processor.h"
+#include "simd.h"
+#include <charconv>
+#include <cstring>
 
 #define _CRT_SECURE_NO_WARNINGS
 
@@ -8,57 +11,363 @@ using namespace char_parsers;
 bool XmlParser::loadNextChunk() noexcept
 {
     // no file checks here; rely on ItemType::kEnd which prevents next()
-    size_t nRead = _fread_nolock(_buffer, 1, _chunkSize, _input);
-    assign(_buffer, _buffer + nRead);
+    if (_streaming) // all data given is in the range already
+    {
+        if (_finished) _eof = true;
+        else _starved = true;
+        return false;
+    }
+    if (_tap) 
+    {
+        _tap->write(_tapBegin, end() - _tapBegin, _tapIndex);
+        _tapBegin = _file.data();
+    }
+    size_t nRead = _file.read();
+    assign(_file.data(), _file.data() + nRead);
+    _index.clear();
     _nReadTotal += nRead; 
     if (nRead) return true;
     _eof = true;
-    if(ferror(_input)) _errorCode = ErrorCode::kErrReadFile;
+    if(_file.error()) _errorCode = ErrorCode::kErrReadFile;
     return false;
 }
 
+UChar XmlParser::appendBounded(char c, bool appendFound) noexcept
+{
+    // same as seek_append(c, appendFound, _text, appendFound) but stops when the text 
+    // reaches _textLimit; c is a char or 0 for '<' and '>'
+    for (;;)
+    {
+        if (empty() && !loadNextChunk()) return 0;
+        auto room = _textLimit - std::min(_textLimit, _text.size());
+        // without appending c, look one char further as c itself is not counted
+        auto e = get() + std::min(size(), room + (appendFound ? 0 : 1));
+        auto p = c ? static_cast<const char*>(memchr(get(), c, e - get())) : 
+            simd::find_first_of(get(), e, { '<','>' });
+        if (p && p != e)
+        {
+            auto n = (p - get()) + (appendFound ? 1 : 0);
+            _text.append(get(), n);
+            setBegin(get() + n);
+            return static_cast<unsigned char>(*p);
+        }
+        auto n = std::min(size(), room);
+        _text.append(get(), n);
+        setBegin(get() + n);
+        if (_text.size() >= _textLimit)
+        {
+            // a run as long as the limit may end right after the chunk
+            if (!appendFound && empty() && !loadNextChunk()) return 0;
+            if (!appendFound && (c ? *get() == c : *get() == '<' || *get() == '>')) 
+                return static_cast<unsigned char>(*get());
+            _overflow = true;
+            return 0;
+        }
+    }
+}
+
+UChar XmlParser::seekBrace(char c, bool appendFound) noexcept
+{
+    // same as seek_append(c, appendFound, _text, appendFound); c is '<', '>' or 0 for both
+    if (_capture && _textLimit != no_limit) return appendBounded(c, appendFound);
+    if (!(_options & Options::kStructuralIndex))
+    {
+        if (!_capture) return c ? seek(c, appendFound) : seek({ '<','>' }, appendFound);
+        if (c) return seek_append(c, appendFound, _text, appendFound);
+        return seek_append({ '<','>' }, appendFound, _text, appendFound);
+    }
+    do
+    {
+        if (!_index.isBuilt(get(), end())) _index.build(get(), size());
+        auto p = _index.find(get(), c);
+        if (p != _index.end())
+        {
+            auto n = (p - get()) + (appendFound ? 1 : 0);
+            if (_capture) _text.append(get(), n);
+            setBegin(get() + n);
+            return static_cast<unsigned char>(*p);
+        }
+        // the index may end before the chunk, which is longer than max_size
+        if (_capture) _text.append(get(), p - get());
+        setBegin(p);
+    } while (!empty() || loadNextChunk());
+    return 0;
+}
+
+UChar XmlParser::skipBlanks() noexcept
+{
+    // same as seek(gt(' ')), vectorized; blanks between items are mostly indentation
+    do
+    {
+        auto p = simd::find_non_blank(get(), end());
+        setBegin(p);
+        if (p != end()) return static_cast<unsigned char>(*p);
+    } while (loadNextChunk());
+    return 0;
+}
+
+void XmlParser::trimText() noexcept
+{
+    // leading blanks are skipped by loadItem() already; a partial piece keeps its
+    // end, as cutPartial() moved trailing blanks to the next piece
+    auto p = _text.data(), e = p + _text.size();
+    if (!_partial) while (e != p && static_cast<unsigned char>(e[-1]) <= ' ') --e;
+    if (_options & Options::kNormalizeSpace)
+    {
+        auto dst = p;
+        while (p != e)
+        {
+            auto blank = std::find_if(p, e, [](char c) { return static_cast<unsigned char>(c) <= ' '; });
+            if (dst != p) memmove(dst, p, blank - p);
+            dst += blank - p;
+            if (blank == e) break;
+            *dst++ = ' ';
+            p = blank + (simd::find_non_blank(blank, e) - blank);
+        }
+        e = dst;
+    }
+    _text.resize(e - _text.data());
+}
+
+UChar XmlParser::nextChar() noexcept
+{
+    if (!_capture) return getc();
+    if (_text.size() >= _textLimit)
+    {
+        _overflow = true;
+        return 0;
+    }
+    return appendc(_text);
+}
+
+namespace
+{
+    std::size_t advanceMatch(std::string_view term, std::size_t k, char c) noexcept
+    {
+        // k chars of term matched; the number matched after c, e.g. 2 for "-->", "--" and '-'
+        if (term[k] == c) return k + 1;
+        for (auto j = k; j; --j)
+        {
+            if (term[j - 1] == c && term.substr(0, j - 1) == term.substr(k - j + 1, j - 1)) return j;
+        }
+        return 0;
+    }
+
+    std::size_t tailMatch(std::string_view term, const char* p, const char* e) noexcept
+    {
+        // the number of chars of term at the end of [p, e), the whole term excluded
+        for (auto j = std::min<std::size_t>(term.size() - 1, e - p); j; --j)
+        {
+            if (memcmp(e - j, term.data(), j) == 0) return j;
+        }
+        return 0;
+    }
+
+    const char* matchTerm(std::string_view term, std::size_t& k, const char* b, const char* e) noexcept
+    {
+        // continues a match of k chars of term in [b, e); the end of the term, or e with
+        // k set to the number of chars of term at the end
+        auto p = b;
+        while (k && k != term.size() && p != e) k = advanceMatch(term, k, *p++);
+        if (k) return p;
+        p = simd::find_string(p, e, term.data(), term.size());
+        if (p != e)
+        {
+            k = term.size();
+            return p + term.size();
+        }
+        k = tailMatch(term, b, e);
+        return e;
+    }
+}
+
+bool XmlParser::seekPast(std::string_view term, std::size_t k, bool termOverLimit) noexcept
+{
+    // seeks term and skips it; appends the span of search and term unless the item 
+    // is skipped; k chars of term are at the end of the text already, e.g. in a piece
+    // carried from the previous one; term may be split between chunks; with 
+    // termOverLimit, term may end past the limit, as it is not kept in the text
+    for (;;)
+    {
+        if (empty() && !loadNextChunk()) return false;
+        auto room = _capture ? _textLimit - std::min(_textLimit, _text.size()) : size();
+        auto b = get(), p = b;
+        if (termOverLimit && room < size())
+        {
+            // the chars of term which may start within the limit; a piece of term at 
+            // the end of the chunk is kept too, cutPartial() moves it to the next piece
+            auto k0 = k;
+            p = matchTerm(term, k, b, b + std::min(size(), room + term.size() - k));
+            if (k != term.size() && p != end())
+            {
+                k = k0;
+                p = b;
+            }
+        }
+        if (p == b)
+        {
+            if (!room)
+            {
+                _overflow = true;
+                return false;
+            }
+            p = matchTerm(term, k, b, b + std::min(size(), room));
+        }
+        if (_capture) _text.append(b, p - b);
+        setBegin(p);
+        if (k == term.size()) return true;
+    }
+}
+
 bool XmlParser::appendRestOfComment() noexcept 
 {  
-    while (seek_append('-', true, _text, true))
-    {
-		UChar c;
-        while ((c =  appendc(_text)) == '-') {}
-        if (c == '>') return true; 
-    } 
-    return false;    
+    return seekPast("-->", 0);
 }
 
 bool XmlParser::appendRestOfCDATA() noexcept 
 {   
-    while (seek_append(']',true, _text, true))
+    // a continuation piece may start with "]]" carried from the previous one
+    std::size_t k = 0;
+    while (_capture && k < 2 && k < _text.size() && _text[_text.size() - 1 - k] == ']') ++k;
+    // the end is erased with kKeepCDATAtags, so it does not count in a piece
+    return seekPast("]]>", k, _capture && (_options & Options::kKeepCDATAtags));
+}
+
+XmlParser::ItemType XmlParser::loadCDATA() noexcept
+{
+    // the rest of CDATA after "<![CDATA[" or the previous piece
+    if (_capture && _limits.maxTextChunk) _textLimit = _limits.maxTextChunk;
+    if (appendRestOfCDATA())
     {
-		UChar c;
-        while ((c =  appendc(_text)) == ']') {}
-        if (c == '>') return true; 
-    } 
-    return false;    
+        if (_capture && (_options & Options::kKeepCDATAtags)) _text.erase(_text.size() - 3);
+        return ItemType::kCData;
+    }
+    if (!_overflow) return ItemType::kEnd;
+    cutPartial(ItemType::kCData);
+    return ItemType::kCData;
+}
+
+void XmlParser::cutPartial(ItemType type) noexcept
+{
+    // moves the tail which may be incomplete to _carry, for the next piece: "]]" of the 
+    // CDATA end, or an entity, or a UTF-8 sequence
+    _overflow = false;
+    _partial = true;
+    auto cut = _text.size();
+    if (type == ItemType::kCData)
+    {
+        while (cut && _text.size() - cut < 2 && _text[cut - 1] == ']') --cut;
+    }
+    else
+    {
+        if (_options & Options::kUnescapeText)
+        {
+            auto amp = _text.rfind('&');
+            if (amp != std::string::npos && cut - amp <= _entityLength && 
+                _text.find(';', amp) == std::string::npos) cut = amp;
+        }
+        if (_options & (Options::kTrimText | Options::kNormalizeSpace))
+        {
+            // blanks at the end may be the end of the block; unless the piece is blank
+            auto n = cut;
+            while (n && static_cast<unsigned char>(_text[n - 1]) <= ' ') --n;
+            if (n && n != cut && cut == _text.size())
+            {
+                // looks past them, for the next piece not to be trimmed to nothing;
+                // a run of blanks longer than a piece is read up to the limit
+                _carry.assign(_text, n);
+                _text.resize(n);
+                UChar c = ' ';
+                if (_options & Options::kNormalizeSpace) 
+                {
+                    c = skipBlanks();
+                    _carry.assign(1, ' ');
+                }
+                else while (_carry.size() < _textLimit)
+                {
+                    if (empty() && !loadNextChunk())
+                    {
+                        c = 0;
+                        break;
+                    }
+                    auto e = get() + std::min(size(), _textLimit - _carry.size());
+                    auto p = simd::find_non_blank(get(), e);
+                    _carry.append(get(), p - get());
+                    setBegin(p);
+                    if (p != e)
+                    {
+                        c = static_cast<unsigned char>(*p);
+                        break;
+                    }
+                }
+                if (_starved) return;  // the item will be loaded again
+                if (!c || c == '<')
+                {
+                    _carry.clear();
+                    _partial = false;
+                }
+                return;
+            }
+            if (n) cut = n;
+            else if (_options & Options::kNormalizeSpace)
+            {
+                // a blank piece: the run is a space, or nothing at the end of the block
+                auto c = skipBlanks();
+                if (_starved) return;  // the item will be loaded again
+                _carry.clear();
+                _text.assign(1, ' ');
+                if (!c || c == '<')
+                {
+                    _text.clear();
+                    _partial = false;
+                }
+                return;
+            }
+        }
+    }
+    for (std::size_t i = 1; i <= 3 && i <= cut; ++i)
+    {
+        auto b = static_cast<unsigned char>(_text[cut - i]);
+        if ((b & 0xC0) == 0x80) continue;  // continuation byte
+        std::size_t len = b >= 0xF0 ? 4 : b >= 0xE0 ? 3 : b >= 0xC0 ? 2 : 1;
+        if (len > i) cut -= i;
+        break;
+    }
+    _carry.assign(_text, cut);
+    _text.resize(cut);
 }
 
 bool XmlParser::appendRestOfPI() noexcept 
 {   
-    while (seek_append('?', true, _text, true))
+    return seekPast("?>", 0);
+}
+
+bool XmlParser::appendRestOfDeclaration() noexcept 
+{   
+    // "<!ENTITY...>", "<!ATTLIST...>" etc. inside a DTD; quoted values may contain '>'
+    UChar q = 0;
+    for (UChar c; (c = nextChar()); )
     {
-        if (appendc(_text) == '>') return true;
+        if (q) { if (c == q) q = 0; }
+        else if (c == '"' || c == '\'') q = c;
+        else if (c == '>') return true;
     }
     return false;    
 }
 
 XmlParser::ItemType XmlParser::loadTag()  noexcept
 {
+	_textLimit = _limits.maxTagLength ? _limits.maxTagLength : no_limit;
 	getc(_text); // init with '<' and skip it;
 	auto c = appendc(_text);
 	if (c == '/') // End-tag: "</" + (any chars except '>')  + '>' 
 	{
-		if (seek_append('>', true, _text, true))
+		if (seekBrace('>', true))
 			return ItemType::kSuffix;
 	}
 	else if (c == '?') // PI (Processor Instruction): "<?" + (any chars except "?>") + "?>" 
 	{
+		skipIf(ItemType::kPI);
 		if (appendRestOfPI()) return ItemType::kPI;
 	}
 	else if (c == '!') // comment, or DTD, or CData: "<!" + (any chars, comments or PI's ) + '>' 
@@ -71,31 +380,32 @@ XmlParser::ItemType XmlParser::loadTag()  noexcept
 
 		if (skip_append_while(_text, "--"))
 		{
+			skipIf(ItemType::kComment);
 			if (appendRestOfComment()) return ItemType::kComment;
 			return ItemType::kEnd;
 		}
 
 		else if (getLevel() && skip_append_while(_text, "[CDATA["))
 		{
+			skipIf(ItemType::kCData);
+			if (_capture && !isElementOfInterest()) _capture = false;
 			if (_options & Options::kKeepCDATAtags) _text.clear();
-
-			if (appendRestOfCDATA())
-			{
-				if (_options & Options::kKeepCDATAtags) _text.erase(_text.size() - 3);
-				return  ItemType::kCData;
-			}
-			return ItemType::kEnd;
+			return loadCDATA();
 		}
 
 		// DTD
 
+		// captured anyway, for entity declarations
+		skipIf(ItemType::kDTD);
+		bool capture = _capture;
+		_capture = true;
 		int iNested = 1;        // count matching '< >'
 
-		while (c = seek_append({ '<','>' }, true, _text, true))
+		while ((c = seekBrace(0, true)))
 		{
 			if (c == '<')  // "...<"
 			{
-				c = appendc(_text);
+				c = nextChar();
 
 				if (c == '!') // "<!-" comment?
 				{
@@ -103,6 +413,7 @@ XmlParser::ItemType XmlParser::loadTag()  noexcept
 					{
 						if (!appendRestOfComment()) break;
 					}
+					else if (!appendRestOfDeclaration()) break;
 				}
 
 				else if (c == '?') // "...<?"
@@ -115,27 +426,89 @@ XmlParser::ItemType XmlParser::loadTag()  noexcept
 			}
 			else // '...>'
 			{
-				if ((--iNested) == 0) return ItemType::kDTD;
+				if ((--iNested) == 0)
+				{
+					_capture = capture;
+					if (declareEntities()) return ItemType::kDTD;
+					_errorCode = ErrorCode::kErrEntity;
+					break;
+				}
 				// // TODO or not : if getLevel() error - DTD shouldn't appear inside elements.
 
 			} // end if '<' or '>'
 		}
 	}
-	else if (c) // start-tag
+	else if (c) return loadStartTag(c);
+
+	return  ItemType::kEnd;
+}
+
+XmlParser::ItemType XmlParser::loadStartTag(UChar c) noexcept
+{
+	// "<" and the first char are in _text; "<>" is odd
+	if (c == '>') return ItemType::kEnd;
+	if (!_filterNames.empty() && !(_options & Options::kNamespaces))
 	{
-		// append until '>' but check if it appended already; "<>" is odd but anyway...
-		// still, TODO: better checks for first character maybe
-		if (c != '>' && seek_append('>', true, _text, true))
+		// the name first; the rest only for elements of interest
+		while (c > ' ' && c != '/' && c != '>') c = nextChar();
+		if (!c) return ItemType::kEnd;
+		std::string_view name(_text.data() + 1, _text.size() - 2);
+		if (!_filter.count(name))
 		{
-			if (_text[_text.size() - 2] != '/') return ItemType::kPrefix;
+			_text.pop_back();
+			char last = static_cast<char>(c);
+			if (c != '>' && !skipRestOfTag(last)) return ItemType::kEnd;
+			if (last != '/')
+			{
+				_text += '>';
+				return ItemType::kPrefix;
+			}
+			_text += "/>";
 			return ItemType::kSelfClosing;
 		}
+		if (c == '>') return ItemType::kPrefix;
 	}
+	// append until '>'; still, TODO: better checks for first character maybe
+	if (seekBrace('>', true))
+	{
+		if (_text[_text.size() - 2] != '/') return ItemType::kPrefix;
+		return ItemType::kSelfClosing;
+	}
+	return ItemType::kEnd;
+}
 
-	return  ItemType::kEnd;
+bool XmlParser::skipRestOfTag(char& last) noexcept
+{
+	// seeks '>' and skips it; last is the char before it, as of the chars skipped
+	do
+	{
+		auto p = static_cast<const char*>(memchr(get(), '>', size()));
+		if (p)
+		{
+			if (p != get()) last = p[-1];
+			setBegin(p + 1);
+			return true;
+		}
+		if (!empty()) last = end()[-1];
+		setBegin(end());
+	} while (loadNextChunk());
+	return false;
 }
 
-void append_utf8(UChar c, std::string& dst)
+void XmlParser::addElementFilter(std::string_view name) noexcept
+{
+    if (_filter.count(name)) return;
+    _filterNames.emplace_back(name);
+    _filter.insert(_filterNames.back());
+}
+
+void XmlParser::clearElementFilter() noexcept
+{
+    _filter.clear();
+    _filterNames.clear();
+}
+
+void append_utf8(UChar c, std::pmr::string& dst)
 {
     if (c < 0x80)                       
         dst += static_cast<char>(c);
@@ -159,25 +532,34 @@ void append_utf8(UChar c, std::string& dst)
 void XmlParser::unescapeText() noexcept
 {
     _tmp.clear();
-    charser it(_text);
-    while(it.seek_append('&', true, _tmp)) // search for '&'; skip it but do not append
+    if (!unescape(_text, _tmp)) _errorCode = ErrorCode::kErrEntity;
+    std::swap(_text, _tmp);
+}
+
+bool XmlParser::unescape(std::string_view src, std::pmr::string& dst) noexcept
+{
+    // appends src to dst with references replaced; false if a declared entity is
+    // recursive or the text added by declared entities exceeds the limit
+    auto limit = _limits.maxEntityExpansion ? _limits.maxEntityExpansion : no_limit;
+    std::size_t added = 0;
+    charser it(src);
+    while(it.seek_append('&', true, dst)) // search for '&'; skip it but do not append
     {
         charser tok; // mnemonic to resolve
 		// search for ';'; skip it but do not append to the mnemonic 
         if(!it.seek_span(';', true, tok))
         {
 			// end of text but no ';'? bad... but let's leave it as is
-			_tmp += '&';
-            _tmp.append(tok); 
-			_tmp += ';';
+			dst += '&';
+            dst.append(tok); 
             break;
         }
         if (tok.skip_if('#'))
         {
             int radix = tok.skip_if('x')? 16 :10;
-            *const_cast<char*>(tok.end()) =  '\0'; // replace ';' with zero for strtoul
-            auto val = strtoul(tok.get(), 0, radix);
-            append_utf8(val, _tmp);
+            std::uint32_t val = 0;
+            std::from_chars(tok.get(), tok.end(), val, radix);
+            append_utf8(val, dst);
             continue;
         }
         char c = 0;
@@ -186,57 +568,234 @@ void XmlParser::unescapeText() noexcept
         else if (tok == ("apos")) c = 0x27;
         else if (tok == ("lt")) c = 0x3C;
         else if (tok == ("gt")) c = 0x3E;
-        else // unknown, write it as is 
+        else 
         {
-            _tmp += '&';
-            _tmp.append(tok);
-            _tmp += ';';
+            auto e = _entities.find(tok);
+            if (e == _entities.end()) // unknown, write it as is 
+            {
+                dst += '&';
+                dst.append(tok);
+                dst += ';';
+                continue;
+            }
+            if (!expandEntity(e->second)) return false;
+            added += e->second.value.size();
+            if (added > limit) return false;
+            dst.append(e->second.value);
             continue;
         }
-        _tmp += c;
+        dst += c;
         continue;
     }
-    std::swap(_text, _tmp);
+    return true;
+}
+
+bool XmlParser::expandEntity(Entity& e) noexcept
+{
+    // replaces references in the value, once; entities may refer to ones declared later
+    if (e.expanded) return true;
+    if (e.expanding) return false;
+    e.expanding = true;
+    std::pmr::string s(getMemoryResource());
+    auto limit = _limits.maxEntityExpansion ? _limits.maxEntityExpansion : no_limit;
+    bool ok = unescape(e.value, s) && s.size() <= limit;
+    e.expanding = false;
+    if (!ok) return false;
+    e.value.assign(s);
+    e.expanded = true;
+    return true;
+}
+
+namespace
+{
+    bool isBlank(char c) noexcept { return static_cast<unsigned char>(c) <= ' '; }
+
+    std::string_view nextToken(std::string_view& s) noexcept
+    {
+        // skips blanks, then takes chars up to the next blank
+        std::size_t i = 0;
+        while (i != s.size() && isBlank(s[i])) ++i;
+        auto n = i;
+        while (n != s.size() && !isBlank(s[n])) ++n;
+        auto token = s.substr(i, n - i);
+        s.remove_prefix(n);
+        return token;
+    }
+}
+
+void XmlParser::declareEntity(std::string_view decl) noexcept
+{
+    // decl is what follows "<!ENTITY": name "value" or name 'value'; the first 
+    // declaration of a name is binding
+    auto name = nextToken(decl);
+    if (name.empty() || name == "%") return;  // a parameter entity
+    while (!decl.empty() && isBlank(decl[0])) decl.remove_prefix(1);
+    if (decl.empty() || (decl[0] != '"' && decl[0] != '\'')) return;  // external: SYSTEM or PUBLIC
+    auto end = decl.find(decl[0], 1);
+    if (end == std::string_view::npos || _entities.count(name)) return;
+    _entityNames.emplace_back(name);
+    _entities.emplace(_entityNames.back(), Entity{ std::pmr::string(decl.substr(1, end - 1), getMemoryResource()), false, false });
+    _entityLength = std::max(_entityLength, name.size() + 2);
+}
+
+void XmlParser::addEntity(std::string_view name, std::string_view value) noexcept
+{
+    // an entity expanded already, e.g. by another parser
+    if (_entities.count(name)) return;
+    _entityNames.emplace_back(name);
+    _entities.emplace(_entityNames.back(), Entity{ std::pmr::string(value, getMemoryResource()), true, false });
+    _entityLength = std::max(_entityLength, name.size() + 2);
+}
+
+bool XmlParser::declareEntities() noexcept
+{
+    // scans the internal subset of the DTD in _text: "<!DOCTYPE name [ ... ]>"
+    std::string_view s(_text);
+    auto pos = s.find('[');
+    while (pos != std::string_view::npos && (pos = s.find('<', pos)) != std::string_view::npos)
+    {
+        auto decl = s.substr(pos);
+        if (decl.substr(0, 4) == "<!--" || decl.substr(0, 2) == "<?")
+        {
+            pos = s.find(decl[1] == '!' ? "-->" : "?>", pos + 2);
+            continue;
+        }
+        // a markup declaration, up to '>' not inside quotes
+        std::size_t n = 1;
+        for (char q = 0; n < decl.size() && (q || decl[n] != '>'); ++n)
+        {
+            if (q) { if (decl[n] == q) q = 0; }
+            else if (decl[n] == '"' || decl[n] == '\'') q = decl[n];
+        }
+        if (decl.substr(0, 8) == "<!ENTITY") declareEntity(decl.substr(8, n - 8));
+        pos += n;
+    }
+    // replacement texts are computed now, not on each reference
+    for (auto& e : _entities)
+    {
+        if (!expandEntity(e.second)) return false;
+    }
+    return true;
+}
+
+std::string_view XmlParser::getEntity(std::string_view name) const noexcept
+{
+    auto e = _entities.find(name);
+    return e != _entities.end() && e->second.expanded ? std::string_view(e->second.value) : std::string_view();
+}
+
+void XmlParser::clearEntities() noexcept
+{
+    _entities.clear();
+    _entityNames.clear();
+    _entityLength = max_entity_length;
 }
 
 XmlParser::ItemType XmlParser::loadText() noexcept
 {
 
-    auto c = seek_append('<', false, _text);
-    if (c && (_options & Options::kUnescapeText)) unescapeText();
-    return c ? ItemType::kEscapedText : ItemType::kEnd;
+    skipIf(ItemType::kEscapedText);
+    if (_capture && !isElementOfInterest()) _capture = false;
+    _textLimit = _capture && _limits.maxTextChunk ? _limits.maxTextChunk : no_limit;
+    auto c = seekBrace('<', false);
+    if (!c && _overflow)
+    {
+        cutPartial(ItemType::kEscapedText);
+        c = '<';
+    }
+    if (c && _capture && (_options & (Options::kTrimText | Options::kNormalizeSpace))) trimText();
+    if (c && _capture && (_options & Options::kUnescapeText)) unescapeText();
+    return c && !error() ? ItemType::kEscapedText : ItemType::kEnd;
 }
 
 bool XmlParser::next() noexcept
 {
-    if(!isEnd()) 
+    if (!_streaming) 
+    {
+        if (_cache.isReading()) return replayItem();
+        if (_cache.isWriting()) return recordItem(loadItem());
+        return loadItem();
+    }
+
+    // remember the state to roll back to if the data ends in the middle of an item
+    auto p = get();
+    auto itemType = _itemType;
+    bool partial = _partial, continued = _continued;
+    bool popped = isElementEnd();
+    if (popped) _popped.assign(getStartTag());
+    if (partial) _carried.assign(_carry);  // the next piece changes it
+    _starved = false;
+    auto b = loadItem();
+    if (!_starved) return b;
+
+    setBegin(p);
+    _itemType = itemType;
+    _partial = partial;
+    _continued = continued;
+    if (partial) _carry.swap(_carried);
+    _errorCode = ErrorCode::kErrOk;
+    _text.clear();
+    if (popped) pushElement(_popped);
+    return false;
+}
+
+bool XmlParser::loadItem() noexcept
+{
+    while(!isEnd()) 
     {
 		
 		// if previous elem ended, remove it from stack
 
-		if (isElementEnd()) _path.popItem();
+		if (isElementEnd()) popElement();
 
         _text.clear();			// empty text buffer
+        _capture = true;
+        _overflow = false;
 
-        auto c = seek(gt(' ')); // skip ascii blanks
+        if (_partial) // the rest of a text block or CDATA
+        {
+            _partial = false;
+            _continued = true;
+            _text.assign(_carry);
+            _itemType = _itemType == ItemType::kCData ? loadCDATA() : loadText();
+            if (!isEnd())
+            {
+                if (getLevel()) return true;
+                continue;
+            }
+            if (getLevel()) _errorCode = ErrorCode::kErrTagUnmatch;
+            return false;
+        }
+        _continued = false;
+
+        auto c = skipBlanks(); // skip ascii blanks
+        _itemPos = getFilePos();
 
         if(c == '<') // a tag?
         {
 			_itemType = loadTag();
+			if (_overflow) 
+			{
+				_errorCode = ErrorCode::kErrTagTooLong;
+				return false;
+			}
 
             if(isElement()) 
             {
-                _path.pushItem(_text) ; // self-closing ones are pushed too, for uniformity
-                return true;
+                // self-closing ones are pushed too, for uniformity
+                if (pushElement(_text)) return true;
+                _itemType = ItemType::kEnd;
+                return false;
             }
 
 			if (!isEnd())
 			{
-				if (getLevel()) return true;
-
-				// document level
-				if (!isSuffix()) return true;
-				// end-tag alone:
+				if (getLevel() || !isSuffix()) 
+				{
+					if (_capture) return true;
+					continue; // skipped item
+				}
+				// document level; end-tag alone:
 				_errorCode = ErrorCode::kErrTagUnmatch;
 				// another odd thing for the document level would be CDATA, but loadTag() checks
 				// for getLevel() - so that if it appears here, it is handled as DTD..
@@ -251,10 +810,10 @@ bool XmlParser::next() noexcept
 			_itemType = loadText();
 
 
-            if (getLevel())  return true;
+            if (getLevel() && _capture)  return true;
 			
             // document level; skip anything outside elements as BOM or garbage 
-            return next(); 
+            continue; 
         }
 
         // eof
@@ -266,89 +825,461 @@ bool XmlParser::next() noexcept
     return false;
 }
 
+bool XmlParser::replayItem() noexcept
+{
+    // same as loadItem(), with the items read from the token cache
+    TokenCache::Item item;
+    while (!isEnd())
+    {
+        if (isElementEnd()) popElement();
+        if (!_cache.read(item))
+        {
+            _itemType = ItemType::kEnd;
+            _eof = true;
+            _nReadTotal = _cache.getKey().size;
+            if (_cache.error()) _errorCode = ErrorCode::kErrReadFile;
+            return false;
+        }
+        _itemType = static_cast<ItemType>(item.type);
+        _partial = item.partial;
+        _continued = item.continued;
+        _itemPos = item.pos;
+        _nReadTotal = item.end;  // so that getFilePos() is as if parsed
+        if (item.implicitText)
+        {
+            _text.assign("</");
+            _text.append(getName());
+            _text += '>';
+        }
+        else _text.assign(item.text);
+
+        if (isElement() && !pushElement(_text))
+        {
+            _itemType = ItemType::kEnd;
+            return false;
+        }
+        if (_itemType == ItemType::kDTD && !declareEntities())
+        {
+            _errorCode = ErrorCode::kErrEntity;
+            _itemType = ItemType::kEnd;
+            return false;
+        }
+        if (!(_skipMask & item.type)) return true;
+    }
+    return false;
+}
+
+bool XmlParser::recordItem(bool loaded) noexcept
+{
+    // items skipped or filtered, or loaded with other settings, would make 
+    // the cache differ from a parse with those of openFile()
+    if (_skipMask || !_filterNames.empty() || !getCacheKey().sameSettings(_cache.getKey()))
+    {
+        _cache.close();
+        return loaded;
+    }
+    if (!loaded)
+    {
+        if (_eof && !error()) _cache.commit();
+        else _cache.close();
+        return false;
+    }
+    TokenCache::Item item;
+    item.type = static_cast<int>(_itemType);
+    item.partial = _partial;
+    item.continued = _continued;
+    item.pos = _itemPos;
+    item.end = getFilePos();
+    item.text = _text;
+    if (isSuffix())
+    {
+        auto name = getName();
+        item.implicitText = item.text.size() == name.size() + 3 && item.text.substr(0, 2) == "</" &&
+            item.text.substr(2, name.size()) == name && item.text.back() == '>';
+    }
+    _cache.write(item);
+    return true;
+}
+
+TokenCache::Key XmlParser::getCacheKey() const noexcept
+{
+    // options and limits which change the items; maxDepth and maxAttributes 
+    // are checked again by pushElement()
+    TokenCache::Key key;
+    key.options = _options & ~(Options::kStructuralIndex | Options::kTokenCache);
+    key.maxTextChunk = _limits.maxTextChunk;
+    key.maxTagLength = _limits.maxTagLength;
+    key.maxEntityExpansion = _limits.maxEntityExpansion;
+    return key;
+}
+
+std::size_t XmlParser::nextBatch(TokenBatch& batch, std::size_t n) noexcept
+{
+    batch.clear();
+    // a stream rolls back the item which runs out of data, and a token cache
+    // replays or records each item; next() does it
+    bool direct = !_streaming && !_cache.isReading() && !_cache.isWriting();
+    // the arrays are sized ahead, by steps for a large n, and written in place;
+    // then they are cut to the items loaded
+    std::size_t i = 0, size = std::min<std::size_t>(n, batch_step);
+    batch.resize(size);
+    std::uint32_t nameId = 0;
+    bool top = false;  // nameId is that of the element on top of the path
+    for (; i != n && (direct ? loadItem() : next()); ++i)
+    {
+        if (i == size) batch.resize(size = std::min(n, size * 2));
+        // the name is of the top element: it changes only with a start-tag, 
+        // or when an element ended before this item
+        if (!top || isElement()) nameId = batch.getNameId(getName());
+        top = !isElementEnd();
+        batch.types[i] = _itemType;
+        batch.levels[i] = (std::uint32_t)getLevel();
+        batch.nameIds[i] = nameId;
+        batch.textOffsets[i] = batch.chars.size();
+        batch.textSizes[i] = _text.size();
+        batch.sourceOffsets[i] = _itemPos;
+        batch.chars.append(_text);
+    }
+    batch.resize(i);
+    return i;
+}
+
+std::uint32_t XmlParser::TokenBatch::getNameId(std::string_view name) noexcept
+{
+    auto it = _nameIds.find(name);
+    if (it != _nameIds.end()) return it->second;
+    auto id = (std::uint32_t)names.size();
+    names.emplace_back(name);
+    _nameIds.emplace(names.back(), id);
+    return id;
+}
+
+void XmlParser::TokenBatch::resize(std::size_t n) noexcept
+{
+    types.resize(n);
+    levels.resize(n);
+    nameIds.resize(n);
+    textOffsets.resize(n);
+    textSizes.resize(n);
+    sourceOffsets.resize(n);
+}
+
+void XmlParser::TokenBatch::clear() noexcept
+{
+    types.clear();
+    levels.clear();
+    nameIds.clear();
+    textOffsets.clear();
+    textSizes.clear();
+    sourceOffsets.clear();
+    chars.clear();
+}
+
 //=====================     Initialization    ==================================//
 
-XmlParser::XmlParser(std::size_t bufferSize) noexcept : 
-    _input(0),
+XmlParser::XmlParser(std::size_t bufferSize, std::pmr::memory_resource* resource) noexcept : 
+    _file((bufferSize + (buffer_gran - 1)) & ~(buffer_gran - 1), resource),
     _errorCode(ErrorCode::kErrOk),
     _nReadTotal(0),     
+    _itemPos(0),
     _eof(false),
     _options(Options::kDefault),
+    _path(resource),
     _itemType(ItemType::kEnd),  // the most important; prevents next()
-    _path(),
-    _text(),
-    _tmp()
+    _text(resource),
+    _tmp(resource),
+    _cache(resource),
+    _tap(0),
+    _tapIndex(0),
+    _tapBegin(0),
+    _streamData(resource),
+    _popped(resource),
+    _carried(resource),
+    _streaming(false),
+    _finished(false),
+    _starved(false),
+    _skipMask(0),
+    _capture(true),
+    _nsNames(resource),
+    _nsIds(resource),
+    _nsBindings(resource),
+    _nsElements(resource),
+    _filterNames(resource),
+    _filter(resource),
+    _carry(resource),
+    _textLimit(no_limit),
+    _overflow(false),
+    _partial(false),
+    _continued(false),
+    _entityNames(resource),
+    _entities(resource),
+    _entityLength(max_entity_length)
+{
+    clearNamespaces();
+    assign(_file.data(), _file.data());
+}
+
+void XmlParser::setLimits(const Limits& v) noexcept
 {
-    _chunkSize = bufferSize + (buffer_gran - 1) & ~(buffer_gran - 1);
-    _buffer = new char[_chunkSize];
-    assign(_buffer, _buffer);
+    _limits = v;
+    if (_limits.maxTextChunk) _limits.maxTextChunk = std::max(_limits.maxTextChunk, min_text_chunk);
 }
 
 bool XmlParser::openFile(const char* path) noexcept
 {
     closeFile();  // if open, closes and resets context
 	_nReadTotal = 0;
+	_itemPos = 0;
 	_errorCode = ErrorCode::kErrOk;
 	_eof = false;
 
-    _input = fopen(path, "rb");
-    if(setvbuf(_input,  nullptr, _IONBF, 0 ) == 0)
+    if ((_options & Options::kTokenCache) && _filterNames.empty())
+    {
+        auto key = getCacheKey();
+        if (TokenCache::getSourceKey(path, key))
+        {
+            if (_cache.openRead(path, key))
+            {
+                _itemType = ItemType::kBegin; // allows replaying
+                return true;
+            }
+            if (!_skipMask) _cache.openWrite(path, key);
+        }
+    }
+
+    if(_file.open(path))
     {
         _itemType = ItemType::kBegin; // allows parsing
         return true;
     }
-    _input = 0;
+    _cache.close();
     _errorCode = ErrorCode::kErrOpenFile;
     return false;
 }
 
+bool XmlParser::openStream() noexcept
+{
+    closeFile();
+    _nReadTotal = 0;
+    _itemPos = 0;
+    _errorCode = ErrorCode::kErrOk;
+    _eof = false;
+    _streaming = true;
+    _finished = false;
+    _starved = false;
+    _streamData.clear();
+    _index.clear();
+    assign(_streamData.data(), _streamData.data());
+    _itemType = ItemType::kBegin; // allows parsing
+    return true;
+}
+
+bool XmlParser::openBuffer(const char* data, std::size_t n) noexcept
+{
+    openStream();
+    _finished = true;
+    _nReadTotal = n;
+    assign(data, data + n);
+    return true;
+}
+
+bool XmlParser::openBuffer(const char* data, std::size_t n, const Scope& scope) noexcept
+{
+    openBuffer(data, n);
+    // declared at the document level, as if by the elements around
+    for (auto& ns : scope.namespaces)
+    {
+        _nsBindings.push_back({ internNamespace(ns.first), internNamespace(ns.second), 0 });
+    }
+    for (auto& e : scope.entities) addEntity(e.first, e.second);
+    return true;
+}
+
+void XmlParser::getScope(Scope& scope) const noexcept
+{
+    scope.namespaces.clear();
+    scope.entities.clear();
+    for (std::size_t level = 1; level < getLevel(); ++level)
+    {
+        _path[level].forEachAttribute([&scope](const Attribute& a)
+        {
+            if (a.name == "xmlns") scope.namespaces.emplace_back(std::string(), a.value);
+            else if (a.name.substr(0, 6) == "xmlns:") scope.namespaces.emplace_back(a.name.substr(6), a.value);
+        });
+    }
+    for (auto& name : _entityNames) scope.entities.emplace_back(name, getEntity(name));
+}
+
+void XmlParser::feed(const char* data, std::size_t n) noexcept
+{
+    if (!_streaming || _finished) return;
+    _streamData.erase(0, get() - _streamData.data()); // drop the data processed
+    _streamData.append(data, n);
+    assign(_streamData.data(), _streamData.data() + _streamData.size());
+    _index.clear();
+    _nReadTotal += n;
+    _starved = false;
+}
+
+void XmlParser::finish() noexcept
+{
+    _finished = true;
+    _starved = false;
+}
+
 void XmlParser::closeFile() noexcept
 {
-    if(_input) 
+    if(_file.isOpen() || _streaming || _cache.isReading()) 
     {
-        fclose(_input); 
+        _file.close();
+        _cache.close();  // a cache not written to the end is discarded
+        _streaming = false;
         _itemType = ItemType::kEnd;  // prevents next()
         _path.clear();
+        clearNamespaces();
+        clearEntities();
+        _partial = _continued = false;
         _text.clear();
-        assign(_buffer, _buffer);
+        assign(_file.data(), _file.data());
     }
 }
 
 XmlParser::~XmlParser()
 {
-    if(_input) fclose(_input);
-    delete[] _buffer;
+}
+
+//=====================     Checkpoint    ==================================//
+
+namespace
+{
+    const char state_magic[4] = { 'X', 'P', 'S', 3 };  // signature + version
+
+    template<typename T>
+    void putValue(std::string& dst, T v) noexcept
+    {
+        dst.append(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+
+    template<typename T>
+    bool getValue(std::string_view& src, T& v) noexcept
+    {
+        if (src.size() < sizeof(T)) return false;
+        memcpy(&v, src.data(), sizeof(T));
+        src.remove_prefix(sizeof(T));
+        return true;
+    }
+
+    void putString(std::string& dst, std::string_view s) noexcept
+    {
+        putValue<uint64_t>(dst, s.size());
+        dst.append(s);
+    }
+
+    bool getString(std::string_view& src, std::string_view& s) noexcept
+    {
+        uint64_t n;
+        if (!getValue(src, n) || n > src.size()) return false;
+        s = src.substr(0, n);
+        src.remove_prefix(n);
+        return true;
+    }
+}
+
+std::string XmlParser::saveState() const noexcept
+{
+    std::string s;
+    if (!_file.isOpen() || error()) return s;
+    s.append(state_magic, sizeof(state_magic));
+    putValue<uint64_t>(s, getFilePos());
+    putValue<int32_t>(s, _options);
+    putValue<int32_t>(s, (int)_itemType);
+    putValue<uint8_t>(s, (_partial ? 1 : 0) | (_continued ? 2 : 0));
+    putString(s, _carry);  // read already, the start of the next piece of a partial item
+    putValue<uint64_t>(s, _entityNames.size());  // declared in the DTD, which is behind
+    for (auto& name : _entityNames)
+    {
+        putString(s, name);
+        putString(s, getEntity(name));
+    }
+    _path.save(s);
+    return s;
+}
+
+bool XmlParser::restoreState(const char* path, std::string_view state) noexcept
+{
+    if (state.substr(0, sizeof(state_magic)) != 
+        std::string_view(state_magic, sizeof(state_magic))) return false;
+    state.remove_prefix(sizeof(state_magic));
+    uint64_t pos;
+    int32_t options, itemType;
+    uint8_t pieces;
+    std::string_view carry;
+    if (!getValue(state, pos) || !getValue(state, options) || 
+        !getValue(state, itemType) || !getValue(state, pieces) ||
+        !getString(state, carry)) return false;
+
+    // the position is in the source; a token cache is not replayed
+    auto current = _options;
+    _options &= ~Options::kTokenCache;
+    bool opened = openFile(path);
+    _options = opened ? options : current;
+    if (!opened) return false;
+    uint64_t nEntities;
+    bool ok = getValue(state, nEntities);
+    for (; ok && nEntities; --nEntities)
+    {
+        std::string_view name, value;
+        ok = getString(state, name) && getString(state, value);
+        if (ok) addEntity(name, value);
+    }
+    ok = ok && _path.restore(state);
+    for (std::size_t i = 1; ok && i <= getLevel(); ++i) ok = pushNamespaces(i);
+    if (!ok || !_file.seek(pos))
+    {
+        closeFile();
+        _errorCode = ErrorCode::kErrReadFile;
+        return false;
+    }
+    _nReadTotal = pos;
+    _itemPos = pos;
+    _itemType = (ItemType)itemType;
+    _partial = (pieces & 1) != 0;
+    _continued = (pieces & 2) != 0;
+    _carry.assign(carry);
+    return true;
 }
 
 //=====================    Path  and tag components  ===========================//
 
 std::string_view XmlParser::Path::reference::getName() const noexcept
 {
-    charser it(*this);
-    if(it.skip()) it.seek_span({' ','>','/'}, false, it);
-    return it;
+    // after '<', up to a blank, '>' or '/'; called for each end-tag replayed from a token cache
+    std::string_view s(*this);
+    if (s.empty()) return s;
+    return s.substr(1, s.find_first_of(" \t\n\r>/", 1) - 1);
 }
 
 bool XmlParser::Path::reference::hasAttributes() const noexcept
 {
     charser it(*this);
-    return it.seek('=', true) && it.seek('"', true) && it.seek('"');
+    if (!it.seek('=', true) || !it.seek(gt(' '))) return false;
+    auto q = it.getc();
+    return (q == '"' || q == '\'') && it.seek(static_cast<char>(q));
 }
 
 std::vector<XmlParser::Attribute> XmlParser::Path::reference::getAttributes() const noexcept
 {
-    charser it(*this);
     std::vector<Attribute> v;
-    while(it.seek(lt_eq(' ')) && it.seek(gt(' '))) // "[blanks...][non-blank]"
-    {
-		charser name;
-		if(!it.seek_span('=', true, name)) break;
-        if (it.getc() != '"') break; // skip leaing quote
-		charser value;
-		if (!it.seek_span('"', true, value)) break;
-        v.push_back(Attribute{name, value});
-    }
-    return std::move(v);
+    forEachAttribute([&v](const Attribute& a) { v.push_back(a); });
+    return v;
+}
+
+std::pmr::vector<XmlParser::Attribute> XmlParser::Path::reference::getAttributes(
+    std::pmr::memory_resource* resource) const noexcept
+{
+    std::pmr::vector<Attribute> v(resource);
+    forEachAttribute([&v](const Attribute& a) { v.push_back(a); });
+    return v;
 }
 
 XmlParser::Path::reference XmlParser::Path::operator[](std::size_t n) const noexcept
@@ -359,12 +1290,40 @@ XmlParser::Path::reference XmlParser::Path::operator[](std::size_t n) const noex
     return reference(_tags.data() + oStart, oEnd - oStart);
 }
 
-void XmlParser::Path::pushItem(const std::string& s) noexcept
+void XmlParser::Path::pushItem(std::string_view s) noexcept
 {
     _tags.append(s);   
     _offsets.push_back(_tags.size());
 }
 
+void XmlParser::Path::save(std::string& dst) const noexcept
+{
+    putValue<uint64_t>(dst, _offsets.size());
+    for (auto o : _offsets) putValue<uint64_t>(dst, o);
+    dst.append(_tags);
+}
+
+bool XmlParser::Path::restore(std::string_view& src) noexcept
+{
+    clear();
+    uint64_t n;
+    if (!getValue(src, n)) return false;
+    for (uint64_t o; n && getValue(src, o); --n)
+    {
+        if (o < (_offsets.empty() ? 0 : _offsets.back())) break;
+        _offsets.push_back(o);
+    }
+    std::size_t nTags = _offsets.empty() ? 0 : _offsets.back();
+    if (n || src.size() != nTags)
+    {
+        clear();
+        return false;
+    }
+    _tags.assign(src);
+    src.remove_prefix(nTags);
+    return true;
+}
+
 void XmlParser::Path::popItem() noexcept
 {
     _offsets.pop_back(); 
@@ -372,6 +1331,110 @@ void XmlParser::Path::popItem() noexcept
     _tags.erase(i);
 }
 
+//=====================     Namespaces    ==================================//
+
+namespace
+{
+    const std::string_view xml_prefix = "xml";
+    const std::string_view xml_uri = "http://www.w3.org/XML/1998/namespace";
+    const std::string_view xmlns_prefix = "xmlns";
+    const std::string_view xmlns_uri = "http://www.w3.org/2000/xmlns/";
+}
+
+std::uint32_t XmlParser::internNamespace(std::string_view uri) noexcept
+{
+    auto it = _nsIds.find(uri);
+    if (it != _nsIds.end()) return it->second;
+    auto id = static_cast<std::uint32_t>(_nsNames.size());
+    _nsNames.emplace_back(uri);
+    _nsIds.emplace(_nsNames.back(), id);
+    return id;
+}
+
+void XmlParser::clearNamespaces() noexcept
+{
+    // ID 0 is ""; the prefixes "xml" and "xmlns" are bound implicitly 
+    if (_nsNames.empty()) internNamespace("");
+    _nsBindings.clear();
+    _nsBindings.push_back({ internNamespace(xml_prefix), internNamespace(xml_uri), 0 });
+    _nsBindings.push_back({ internNamespace(xmlns_prefix), internNamespace(xmlns_uri), 0 });
+    _nsElements.clear();
+}
+
+std::uint32_t XmlParser::resolvePrefix(std::string_view prefix) const noexcept
+{
+    auto it = _nsIds.find(prefix);
+    if (it != _nsIds.end())
+    {
+        for (auto b = _nsBindings.rbegin(); b != _nsBindings.rend(); ++b)
+        {
+            if (b->prefix == it->second) return b->uri;
+        }
+    }
+    return prefix.empty() ? 0 : unbound_namespace; // no default namespace declared
+}
+
+bool XmlParser::pushNamespaces(std::size_t level) noexcept
+{
+    if (!(_options & Options::kNamespaces)) return true;
+    auto tag = _path[level];
+    tag.forEachAttribute([this, level](const Attribute& a)
+    {
+        if (a.name.substr(0, xmlns_prefix.size()) != xmlns_prefix) return;
+        auto prefix = a.name.substr(xmlns_prefix.size());
+        if (!prefix.empty() && prefix[0] != ':') return;  // not a declaration
+        if (!prefix.empty()) prefix.remove_prefix(1);
+        _nsBindings.push_back({ internNamespace(prefix), internNamespace(a.value), level });
+    });
+    auto name = tag.getName();
+    auto colon = name.find(':');
+    auto localPos = colon == std::string_view::npos ? 0 : colon + 1;
+    auto uri = resolvePrefix(name.substr(0, localPos ? colon : 0));
+    _nsElements.push_back({ uri, localPos });
+    if (uri != unbound_namespace) return true;
+    _errorCode = ErrorCode::kErrNamespace;
+    return false;
+}
+
+bool XmlParser::pushElement(std::string_view tag) noexcept
+{
+    if (_limits.maxDepth && getLevel() >= _limits.maxDepth)
+    {
+        _errorCode = ErrorCode::kErrTooDeep;
+        return false;
+    }
+    _path.pushItem(tag);
+    if (_limits.maxAttributes)
+    {
+        std::size_t n = 0;
+        getStartTag().forEachAttribute([&n](const Attribute&) { ++n; });
+        if (n > _limits.maxAttributes)
+        {
+            _errorCode = ErrorCode::kErrTooManyAttributes;
+            return false;
+        }
+    }
+    return pushNamespaces(getLevel());
+}
+
+void XmlParser::popElement() noexcept
+{
+    _path.popItem();
+    auto level = getLevel();
+    if (_nsElements.size() > level) _nsElements.pop_back();
+    while (_nsBindings.back().level > level) _nsBindings.pop_back();
+}
+
+std::uint32_t XmlParser::getNamespaceId(const Attribute& a) const noexcept
+{
+    auto colon = a.name.find(':');
+    if (colon == std::string_view::npos) 
+    {
+        return a.name == xmlns_prefix ? resolvePrefix(xmlns_prefix) : 0;
+    }
+    return resolvePrefix(a.name.substr(0, colon));
+}
+
 //=====================     Write    ==================================//
 
 bool XmlParser::writeItem(IWriter & writer, std::size_t userIndex) 
@@ -388,6 +1451,38 @@ void XmlParser::writeElement(IWriter & writer, std::size_t userIndex)
     } 
 }
 
+bool XmlParser::copyElement(IWriter & writer, std::size_t userIndex, std::string_view startTag)
+{
+    if (!isElement() || _streaming) return false;
+    writer.write(startTag.empty() ? _text : startTag, userIndex); // the start-tag is loaded already
+    if (isSelfClosing()) return true;
+    auto lvl = getLevel();
+    if (_cache.isReading())
+    {
+        while (!(isSuffix() && getLevel() == lvl))
+        {
+            if (!next()) return false;
+            writer.write(_text, userIndex);
+        }
+        return true;
+    }
+    _tap = &writer;
+    _tapIndex = userIndex;
+    _tapBegin = get();
+    bool ok = true;
+    while (!(isSuffix() && getLevel() == lvl))
+    {
+        if (!next())
+        {
+            ok = false;
+            break;
+        }
+    }
+    writer.write(_tapBegin, get() - _tapBegin, userIndex);
+    _tap = 0;
+    return ok;
+}
+
 bool XmlParser::FileWriter::openFiles(std::string dir, 
     std::initializer_list<const char*>filenames) noexcept
 {
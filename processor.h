@@ -1,9 +1,21 @@
 #pragma once
 
 #include "charser.h"
+#include "structural.h"
+#include "filereader.h"
+#include "tokencache.h"
+#include "values.h"
 #include <algorithm>
 #include <vector>
 #include <fstream>
+#include <memory_resource>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <iterator>
+
+class XmlTree;
 
 class XmlParser: private char_parsers::chunk_charser<XmlParser> {
 
@@ -16,15 +28,75 @@ class XmlParser: private char_parsers::chunk_charser<XmlParser> {
 
     /// Constructor. Allocates memory for the file buffer.
     ///\ param bufferSize Size of file buffer.
-    XmlParser(std::size_t bufferSize = default_chunk_size) noexcept;
+    ///\ param resource Memory resource for the text, path and attributes.
+    XmlParser(std::size_t bufferSize = default_chunk_size, 
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) noexcept;
 
     /// Opens a file for processing. A previous file will be closed.  
     ///\ param path Full path to the file.
     /// \return True if opened succesfully, false otherwise
+    /// \detail With Options::kTokenCache, if the file has a token cache made 
+    /// with the same options and limits, and its size and modification time 
+    /// have not changed, the items are replayed from the cache instead; if not,
+    /// and no items are skipped or filtered, the cache is written while the 
+    /// file is parsed, and kept if the parsing reaches the end without errors.
     bool openFile(const char* path) noexcept;
 
-    /// Closes the opened file. This is done automatically by openFile 
-    /// and destructor.
+    /// Get and set the policies of file reading and the file buffer
+    /// (FileReader::Policy); they take effect at the next openFile().
+    int getReadPolicy() const noexcept { return _file.getPolicy(); }
+    void setReadPolicy(int v) noexcept { _file.setPolicy(v); }
+
+    ///@{ Stream mode: data is given by the caller piece by piece
+
+    /// Starts processing of data given by feed(). A previous file will be closed.
+    /// \return True
+    bool openStream() noexcept;
+
+    /// Gives the next piece of data in stream mode; the data is copied.
+    /// Call it when next() returned false and needsInput() is true.
+    void feed(const char* data, std::size_t n) noexcept;
+
+    /// Tells that there is no more data in stream mode.
+    void finish() noexcept;
+
+    /// True if next() returned false because the data given by feed() ended
+    /// in the middle of an item; the item will be loaded again after feed()
+    /// or finish().
+    bool needsInput() const noexcept { return _starved; }
+
+    /// Starts processing of a document in memory, without copying it. 
+    /// A previous file will be closed. The data must be valid until 
+    /// closeFile() or the next open.
+    /// \return True
+    bool openBuffer(const char* data, std::size_t n) noexcept;
+
+    /// What a part of a document, e.g. an element cut out of it, takes from 
+    /// the rest: the namespace declarations in scope and the entities declared
+    /// in the DTD.
+    struct Scope
+    {
+        /// Prefix ("" for the default namespace) and URI, outermost first.
+        std::vector<std::pair<std::string, std::string> > namespaces;
+        /// Name and replacement text.
+        std::vector<std::pair<std::string, std::string> > entities;
+
+        bool operator==(const Scope& rhs) const noexcept
+        { return namespaces == rhs.namespaces && entities == rhs.entities; }
+    };
+
+    /// Gets the scope of the current element as seen from outside it: the
+    /// namespace declarations of its ancestors, not its own, and the entities.
+    void getScope(Scope& scope) const noexcept;
+
+    /// Same as openBuffer(data, n) for a part of another document; the 
+    /// declarations of a scope given by getScope() on that document apply.
+    bool openBuffer(const char* data, std::size_t n, const Scope& scope) noexcept;
+
+    ///}@
+
+    /// Closes the opened file, stream or buffer. This is done automatically
+    /// by openFile and destructor.
     void closeFile() noexcept;
 
     /// Destructor. Closes any opened file and frees the buffer.
@@ -37,10 +109,19 @@ class XmlParser: private char_parsers::chunk_charser<XmlParser> {
         {
             kUnescapeText = 1,   /// Replace mnemonics with actual values
             kKeepCDATAtags = 2,  /// Keep CDATA tags (otherwise removed)
+            kStructuralIndex = 4, /// Find tag braces via a vectorized index of each chunk
+            kNamespaces = 8,     /// Resolve namespaces of elements (see getNamespaceId())
+            kTrimText = 16,      /// Remove blanks at the end of text blocks, as those at the start
+            kNormalizeSpace = 32, /// Replace runs of blanks in text blocks with a space; implies kTrimText
+            kTokenCache = 64,    /// Keep the items of files in token caches next to them (see openFile())
             kDefault = 0
         };
     };
 
+    /// Gets the memory resource passed to the constructor.
+    std::pmr::memory_resource* getMemoryResource() const noexcept 
+    { return _text.get_allocator().resource(); }
+
     /// Get and set currently used options.
     int getOptions() const noexcept { return _options; }
     void setOptions(int v) noexcept {_options = v;}
@@ -52,9 +133,40 @@ class XmlParser: private char_parsers::chunk_charser<XmlParser> {
         kErrOpenFile = 1,      /// Can't open file.
         kErrReadFile  = 2,     /// Can't read from file.
         kErrTagUnclosed = 4,   /// A tag without the closing brace.
-        kErrTagUnmatch = 8     /// An end-tag is missing.
+        kErrTagUnmatch = 8,    /// An end-tag is missing.
+        kErrNamespace = 16,    /// A prefix is not bound to a namespace.
+        kErrTagTooLong = 32,   /// A tag is longer than Limits::maxTagLength.
+        kErrTooDeep = 64,      /// Elements are nested deeper than Limits::maxDepth.
+        kErrTooManyAttributes = 128, /// A start-tag has more than Limits::maxAttributes.
+        kErrEntity = 256       /// An entity refers to itself or expands beyond Limits::maxEntityExpansion.
     };
 
+    /// Limits of resources per item; 0 means no limit.
+    struct Limits
+    {
+        /// Maximal size of a text or CDATA item; longer blocks are delivered as 
+        /// a series of items (see isPartial()). Values less than min_text_chunk 
+        /// are taken as min_text_chunk.
+        std::size_t maxTextChunk = 0;
+        /// Maximal length of a tag, a comment, a PI or a DTD.
+        std::size_t maxTagLength = 0;
+        /// Maximal level of elements.
+        std::size_t maxDepth = 0;
+        /// Maximal number of attributes of an element.
+        std::size_t maxAttributes = 0;
+        /// Maximal length of the replacement text of an entity declared in the DTD,
+        /// and of the text added to a text item by replacing such entities; 
+        /// guards against exponential expansion. Unlike the others, it is 1 MB 
+        /// by default.
+        std::size_t maxEntityExpansion = 0x100000;
+    };
+
+    static constexpr std::size_t min_text_chunk = 64;
+
+    /// Get and set currently used limits.
+    const Limits& getLimits() const noexcept { return _limits; }
+    void setLimits(const Limits& v) noexcept;
+
     /// Types of entities
     enum struct ItemType 
     {
@@ -71,10 +183,34 @@ class XmlParser: private char_parsers::chunk_charser<XmlParser> {
         kBegin = 256            /// Initial state, the start of processing 
     }; 
 
+    /// Get and set the item types to skip: ItemType bits combined. Skipped items
+    /// are only scanned for their end, never loaded, and next() goes on to the 
+    /// next item. Elements cannot be skipped, as they form the path; their bits
+    /// are ignored. A DTD is loaded anyway for its entity declarations, but not
+    /// returned.
+    int getSkipMask() const noexcept { return _skipMask; }
+    void setSkipMask(int v) noexcept 
+    { 
+        _skipMask = v & ((int)ItemType::kEscapedText | (int)ItemType::kCData | 
+            (int)ItemType::kPI | (int)ItemType::kComment | (int)ItemType::kDTD);
+    }
+
     /// Atribute of an element
     struct  Attribute  {
         std::string_view name; 
         std::string_view value;
+
+        /// Typed value; see the char_parsers::parse_xxx() functions
+        bool getInt(std::int64_t& v, bool trim = true) const noexcept
+        { return char_parsers::parse_int(value, v, trim); }
+        bool getUInt(std::uint64_t& v, bool trim = true) const noexcept
+        { return char_parsers::parse_uint(value, v, trim); }
+        bool getDouble(double& v, bool trim = true) const noexcept
+        { return char_parsers::parse_double(value, v, trim); }
+        bool getBool(bool& v, bool trim = true) const noexcept
+        { return char_parsers::parse_bool(value, v, trim); }
+        bool getTimestamp(char_parsers::timestamp& v, bool trim = true) const noexcept
+        { return char_parsers::parse_timestamp(value, v, trim); }
     };
 
     struct Path 
@@ -88,6 +224,11 @@ class XmlParser: private char_parsers::chunk_charser<XmlParser> {
             bool hasAttributes() const noexcept;
             /// gets start-tag's attributes
             std::vector<Attribute> getAttributes() const noexcept;
+            /// gets start-tag's attributes, in a vector allocated from a memory resource
+            std::pmr::vector<Attribute> getAttributes(std::pmr::memory_resource* resource) const noexcept;
+            /// calls f(const Attribute&) for each of start-tag's attributes
+            template<class F>
+            void forEachAttribute(F f) const noexcept;
         };
         struct iterator
         {
@@ -95,7 +236,7 @@ class XmlParser: private char_parsers::chunk_charser<XmlParser> {
             void operator++() noexcept { ++_idx; }
             const Path::reference operator*() const noexcept { return _path[_idx]; }
             private:
-            friend typename XmlParser::Path;
+            friend struct XmlParser::Path;
             iterator(const Path& path, std::size_t i):_path(path), _idx(i){}
             const Path& _path;
             std::size_t _idx;
@@ -110,13 +251,55 @@ class XmlParser: private char_parsers::chunk_charser<XmlParser> {
         // Gets an element; safe: returns empty string when out-of-bounds.
         reference operator[](std::size_t) const noexcept;
         private:
-        Path(): _offsets(), _tags() {}
-        std::vector<std::size_t> _offsets;
-        std::string _tags;
-        void pushItem(const std::string& s) noexcept;
+        Path(std::pmr::memory_resource* resource): _offsets(resource), _tags(resource) {}
+        std::pmr::vector<std::size_t> _offsets;
+        std::pmr::string _tags;
+        void pushItem(std::string_view s) noexcept;
         void popItem()  noexcept;
         void clear()  noexcept { _offsets.clear(); _tags.clear(); }
-        friend typename XmlParser;
+        void save(std::string& dst) const noexcept;
+        bool restore(std::string_view& src) noexcept;
+        friend class ::XmlParser;
+    };
+
+    /// Items loaded by nextBatch(), as parallel arrays.
+    struct TokenBatch
+    {
+        TokenBatch(std::pmr::memory_resource* resource = std::pmr::get_default_resource()):
+            types(resource), levels(resource), nameIds(resource), textOffsets(resource),
+            textSizes(resource), sourceOffsets(resource), chars(resource), names(resource),
+            _nameIds(resource) {}
+        TokenBatch(const TokenBatch&) = delete;
+        TokenBatch& operator=(const TokenBatch&) = delete;
+
+        std::pmr::vector<ItemType> types;
+        std::pmr::vector<std::uint32_t> levels;          // see getLevel()
+        std::pmr::vector<std::uint32_t> nameIds;         // see getName(); index in names
+        std::pmr::vector<std::uint64_t> textOffsets;     // item's text in chars
+        std::pmr::vector<std::uint64_t> textSizes;
+        std::pmr::vector<std::uint64_t> sourceOffsets;   // see getItemPos()
+        std::pmr::string chars;                          // texts of all items
+
+        /// Names met so far; kept by clear(), so that IDs are the same
+        /// for all batches
+        std::pmr::deque<std::pmr::string> names;
+
+        std::size_t size() const noexcept { return types.size(); }
+        bool empty() const noexcept { return types.empty(); }
+        std::string_view getText(std::size_t i) const noexcept
+        { return std::string_view(chars.data() + textOffsets[i], textSizes[i]); }
+        std::string_view getName(std::size_t i) const noexcept { return names[nameIds[i]]; }
+
+        /// Gets the ID of a name; IDs of names not met yet are added.
+        std::uint32_t getNameId(std::string_view name) noexcept;
+
+        /// Removes all items but keeps names and the allocated memory.
+        void clear() noexcept;
+
+        private:
+        friend class ::XmlParser;
+        std::pmr::unordered_map<std::string_view, std::uint32_t> _nameIds; // views into names
+        void resize(std::size_t n) noexcept;  // of the arrays, chars aside
     };
 
     ///@{ Current state of the processor
@@ -136,7 +319,28 @@ class XmlParser: private char_parsers::chunk_charser<XmlParser> {
     /// Gets the number of bytes processed at this moment. 
     std::size_t getFilePos() const noexcept 
     { return _nReadTotal - size(); }
- 
+
+    /// Gets the position of the current item in the file.
+    std::size_t getItemPos() const noexcept { return _itemPos; }
+
+    ///}
+
+    ///@{ Checkpoint
+
+    /// Saves the state needed to resume processing later: the file position,
+    /// the path, the current item type, the options, the entities declared
+    /// in the DTD and, for a partial item, the start of its next piece.
+    /// \return A compact binary blob; empty if error() or no file is open,
+    /// or the items are replayed from a token cache.
+    std::string saveState() const noexcept;
+
+    /// Opens a file and continues processing from a state made by saveState()
+    /// on the same file. The text of the current item is not restored.
+    /// \param path Full path to the file.
+    /// \param state The blob returned by saveState().
+    /// \return True if restored succesfully, false otherwise
+    bool restoreState(const char* path, std::string_view state) noexcept;
+
     ///}
 
     ///@{
@@ -212,7 +416,33 @@ class XmlParser: private char_parsers::chunk_charser<XmlParser> {
     /// gets the tag's text including angle brackets.
     /// For ItemType::kEnd, the text is either empty or contains 
     /// an incomplete tag which produced error.
-	const std::string& getText() const noexcept { return _text; }
+    /// The view is valid until the next item; copy it as std::string(getText()).
+	std::string_view getText() const noexcept { return _text; }
+
+    /// True if the current item is a piece of a text or CDATA block longer than
+    /// Limits::maxTextChunk, and more pieces of it follow. The pieces are cut so
+    /// that no entity, UTF-8 sequence or CDATA end is split, and a piece is 
+    /// never empty; except with Options::kTrimText, for a block ending with 
+    /// a run of blanks longer than the limit.
+    bool isPartial() const noexcept { return _partial; }
+
+    /// True if the current item continues the previous, partial, one.
+    bool isContinuation() const noexcept { return _continued; }
+
+    /// Current item's text as a typed value, parsed in place.
+    /// \param trim Ignore blanks around the value.
+    /// \return False if the text is not a value of the type; v is unchanged then.
+    /// \detail See the char_parsers::parse_xxx() functions for the formats.
+    bool getInt(std::int64_t& v, bool trim = true) const noexcept
+    { return char_parsers::parse_int(_text, v, trim); }
+    bool getUInt(std::uint64_t& v, bool trim = true) const noexcept
+    { return char_parsers::parse_uint(_text, v, trim); }
+    bool getDouble(double& v, bool trim = true) const noexcept
+    { return char_parsers::parse_double(_text, v, trim); }
+    bool getBool(bool& v, bool trim = true) const noexcept
+    { return char_parsers::parse_bool(_text, v, trim); }
+    bool getTimestamp(char_parsers::timestamp& v, bool trim = true) const noexcept
+    { return char_parsers::parse_timestamp(_text, v, trim); }
 
     ///}@
 
@@ -238,6 +468,63 @@ class XmlParser: private char_parsers::chunk_charser<XmlParser> {
     std::vector<Attribute> getAttributes() const noexcept
     { return getStartTag().getAttributes();}
 
+    /// Same, in a vector allocated from a memory resource, e.g. 
+    /// getMemoryResource().
+    std::pmr::vector<Attribute> getAttributes(std::pmr::memory_resource* resource) const noexcept
+    { return getStartTag().getAttributes(resource);}
+
+    ///}@
+
+    ///@{
+    /** Element filter: a set of names of elements of interest. Start-tags of
+    other elements are scanned only for their end and loaded as "<name>" or 
+    "<name/>", without attributes, and their text and CDATA blocks are skipped;
+    those of nested elements of interest are not. Names are compared as they 
+    are written, with prefixes. With Options::kNamespaces, tags are loaded in 
+    full, as they may declare namespaces. */
+
+    /// Adds a name to the set; takes effect at the next item.
+    void addElementFilter(std::string_view name) noexcept;
+
+    /// Clears the set, so that all elements are loaded in full.
+    void clearElementFilter() noexcept;
+
+    /// True if the current element is loaded in full: the set is empty or has 
+    /// the element's name.
+    bool isElementOfInterest() const noexcept
+    { return _filterNames.empty() || _filter.count(getName()) != 0; }
+
+    ///}@
+
+    ///@{
+    /** Namespaces; require Options::kNamespaces set before openFile().
+    Namespace URIs and prefixes are interned: each distinct string gets
+    an ID which stays the same until the parser is destroyed, so that names
+    can be compared by ID. ID 0 is the empty string, i.e. no namespace. */
+
+    static const std::uint32_t unbound_namespace = 0xFFFFFFFF;
+
+    /// Current element's namespace ID; validity as of getName().
+    std::uint32_t getNamespaceId() const noexcept
+    { return _nsElements.empty() ? 0 : _nsElements.back().uri; }
+
+    /// Current element's name without the prefix; validity as of getName().
+    std::string_view getLocalName() const noexcept
+    { return getName().substr(_nsElements.empty() ? 0 : _nsElements.back().localPos); }
+
+    /// Namespace ID of an attribute of the current element; attributes without
+    /// a prefix have no namespace.
+    /// \return The ID or unbound_namespace if the prefix is not declared.
+    std::uint32_t getNamespaceId(const Attribute& a) const noexcept;
+
+    /// Gets the ID of a string, e.g. a namespace URI to compare getNamespaceId()
+    /// with; IDs of strings not met yet are added.
+    std::uint32_t internNamespace(std::string_view uri) noexcept;
+
+    /// Gets the string of an ID.
+    std::string_view getNamespaceUri(std::uint32_t id) const noexcept
+    { return id < _nsNames.size() ? std::string_view(_nsNames[id]) : std::string_view(); }
+
     ///}@
 
     ///@{
@@ -277,13 +564,15 @@ class XmlParser: private char_parsers::chunk_charser<XmlParser> {
 
     /// Loads next item.
     /// \return False if EOF is reached or data error occured -
-    /// in either case furher processing is not possible.
+    /// in either case furher processing is not possible; in stream mode,
+    /// also if needsInput().
     /// \detail 
     /// The iterated items are: all element's tags (start, end, and 
     /// self-closing ones), text blocks, CDATA text blocks, processing 
     /// instuctions (PI), comments, type declarations (DTD). Text blocks may 
     /// come more than once if interleaved with nested entities or enclosed 
-    /// by CDATA-s. 
+    /// by CDATA-s. Blanks between items, e.g. indentation, are skipped: text 
+    /// blocks of blanks only are not items.
     
     bool next() noexcept;
 
@@ -296,10 +585,78 @@ class XmlParser: private char_parsers::chunk_charser<XmlParser> {
         return !(isElementEnd() && getLevel() == lvl) ? next() : false;
     }
 
-    /// Replaces mnenonics in current text block with actual values.
-    /// If Options::kUnescapeText is set, it is done automatically.
+    /// Properties of an item, as given by items().
+    struct ItemView
+    {
+        ItemType type;
+        std::size_t level;
+        std::string_view name;
+        std::string_view text;
+    };
+
+    /// Input range of items, for range-for loops and std::ranges algorithms.
+    class ItemRange
+    {
+        public:
+        struct sentinel {};
+        struct iterator
+        {
+            using iterator_concept = std::input_iterator_tag;
+            using iterator_category = std::input_iterator_tag;
+            using value_type = ItemView;
+            using difference_type = std::ptrdiff_t;
+            using reference = ItemView;
+            using pointer = void;
+
+            iterator(XmlParser* p = 0) noexcept : _parser(p) {}
+            ItemView operator*() const noexcept 
+            { 
+                return ItemView{ _parser->getItemType(), _parser->getLevel(),
+                    _parser->getName(), _parser->getText() };
+            }
+            iterator& operator++() noexcept { if (!_parser->next()) _parser = 0; return *this; }
+            void operator++(int) noexcept { ++*this; }
+            bool operator==(sentinel) const noexcept { return !_parser; }
+            bool operator!=(sentinel) const noexcept { return _parser; }
+            friend bool operator==(sentinel s, const iterator& it) noexcept { return it == s; }
+            friend bool operator!=(sentinel s, const iterator& it) noexcept { return it != s; }
+            private:
+            XmlParser* _parser;
+        };
+        /// Loads the first item, so that begin() should be called once.
+        iterator begin() const noexcept { return iterator(_parser->next() ? _parser : 0); }
+        sentinel end() const noexcept { return sentinel(); }
+        private:
+        friend class XmlParser;
+        ItemRange(XmlParser* p) noexcept : _parser(p) {}
+        XmlParser* _parser;
+    };
+
+    /// Gets the items as a range; iteration calls next().
+    ItemRange items() noexcept { return ItemRange(this); }
+
+    /// Replaces mnenonics in current text block with actual values: the
+    /// predefined entities, character references and general entities declared 
+    /// in the internal subset of the DTD (<!ENTITY name "value">); unknown ones 
+    /// are left as is. If Options::kUnescapeText is set, it is done automatically.
+    /// Sets ErrorCode::kErrEntity if the text would grow beyond 
+    /// Limits::maxEntityExpansion.
     void unescapeText() noexcept;
 
+    /// Replacement text of an entity declared in the DTD, with references in it 
+    /// replaced; empty if not declared. Valid until the next open.
+    std::string_view getEntity(std::string_view name) const noexcept;
+
+    /// Loads up to n next items into arrays; same as calling next() 
+    /// n times, copying each item's properties. The items are loaded in
+    /// one loop, bypassing next() unless the data is a stream or a token 
+    /// cache is used, into arrays sized ahead; a name is looked up only 
+    /// when the element on top of the path changes.
+    /// \param batch Receives the items; previous ones are cleared.
+    /// \return The number of items loaded; less than n if EOF is reached
+    /// or data error occured.
+    std::size_t nextBatch(TokenBatch& batch, std::size_t n) noexcept;
+
     ///}@
 
     ///@{ Write
@@ -340,30 +697,154 @@ class XmlParser: private char_parsers::chunk_charser<XmlParser> {
     /// stops at the end-tag of this element.
     void writeElement(IWriter& writer, std::size_t userIndex);
 
+    /// Same as writeElement() but passes the element's source data as is,
+    /// directly from the read buffer, in as few calls as possible. Items 
+    /// replayed from a token cache have no source data; their texts are 
+    /// written, with the end-tag. Not available in stream mode, where feed()
+    /// moves the data and the element may end in data not given yet: nothing
+    /// is written then, and the parser stays at the start-tag.
+    /// \param startTag If not empty, written instead of the start-tag, e.g. 
+    /// with attributes added.
+    /// \return False if the current item is not an element, in stream mode, 
+    /// or if EOF or data error occured before the end-tag.
+    bool copyElement(IWriter& writer, std::size_t userIndex, std::string_view startTag = {});
+
+    ///}@
+
+    ///@{ Capture
+
+    /// Builds a compact tree of the current element's subtree and stops at 
+    /// the end-tag of this element, like writeElement().
+    /// \param tree Receives the subtree; its previous contents are cleared 
+    /// but its memory is reused.
+    /// \return False if the current item is not a start-tag or EOF or data 
+    /// error occured before the end-tag.
+    bool captureElement(XmlTree& tree) noexcept;
+
     ///}@
 
     private:
     
-    //static const int max_tag_length = 0x100000;  // unused yet
+    static const std::size_t no_limit = static_cast<std::size_t>(-1);
+    static const std::size_t max_entity_length = 16;
+    static constexpr std::size_t batch_step = 0x1000;  // items nextBatch() sizes the arrays for at once  // "&#x10FFFF;" and the like, not declared ones
    
-    char* _buffer;
-    int _chunkSize;
-    FILE* _input;
+    FileReader _file;
     ErrorCode _errorCode;
     std::size_t _nReadTotal;
+    std::size_t _itemPos;
     bool _eof;
     int _options;
   
     Path _path;  // Stack of start-tags 
     ItemType _itemType;
-    std::string _text;   
-    std::string _tmp;   
+    std::pmr::string _text;   
+    std::pmr::string _tmp;   
+    TokenCache _cache;  // being read or written; see Options::kTokenCache
+
+    IWriter* _tap;  // receives the source data while copyElement()
+    std::size_t _tapIndex;
+    const char* _tapBegin;
+
+    std::pmr::string _streamData;  // stream mode data not processed yet 
+    std::pmr::string _popped;  // tag popped by next() in stream mode; for roll back
+    std::pmr::string _carried; // _carry before next() in stream mode; for roll back
+    bool _streaming;   // stream or buffer mode 
+    bool _finished;    // no more data in stream mode
+    bool _starved;     // data ended in the middle of an item in stream mode
+
+    int _skipMask;     // ItemType bits of items to skip without loading
+    bool _capture;     // false while skipping the current item
+
+    StructuralIndex _index;  // built lazily for each chunk with kStructuralIndex
+
+    struct NsBinding
+    {
+        std::uint32_t prefix;
+        std::uint32_t uri;
+        std::size_t level;  // of the element declaring it
+    };
+    struct NsElement
+    {
+        std::uint32_t uri;
+        std::size_t localPos;  // local name's offset in the name
+    };
+    std::pmr::deque<std::pmr::string> _nsNames;  // interned prefixes and URIs; ID is the index
+    std::pmr::unordered_map<std::string_view, std::uint32_t> _nsIds;
+    std::pmr::vector<NsBinding> _nsBindings;  // declarations in scope, innermost last
+    std::pmr::vector<NsElement> _nsElements;  // per level of path
+
+    std::pmr::deque<std::pmr::string> _filterNames;  // see addElementFilter()
+    std::pmr::unordered_set<std::string_view> _filter;  // views into _filterNames
+
+    Limits _limits;
+    std::pmr::string _carry;   // the start of the next piece of a partial item
+    std::size_t _textLimit;    // of the current item's text; no_limit or as of _limits
+    bool _overflow;    // the text reached _textLimit 
+    bool _partial;     // see isPartial()
+    bool _continued;   // see isContinuation()
+
+    struct Entity
+    {
+        std::pmr::string value;  // replacement text
+        bool expanded;      // references in value are replaced
+        bool expanding;     // being expanded; a reference to it is recursive
+    };
+    std::pmr::deque<std::pmr::string> _entityNames;  // declared in the DTD
+    std::pmr::unordered_map<std::string_view, Entity> _entities;  // keys view into _entityNames
+    std::size_t _entityLength;  // of the longest reference, "&name;"
 
     bool loadNextChunk() noexcept;
+    bool loadItem() noexcept;
+    bool replayItem() noexcept;
+    bool recordItem(bool loaded) noexcept;
+    TokenCache::Key getCacheKey() const noexcept;
+    bool pushElement(std::string_view tag) noexcept;
+    void popElement() noexcept;
+    bool pushNamespaces(std::size_t level) noexcept;
+    void clearNamespaces() noexcept;
+    std::uint32_t resolvePrefix(std::string_view prefix) const noexcept;
+    void skipIf(ItemType t) noexcept { _capture = !(_skipMask & (int)t); }
+    bool seekPast(std::string_view term, std::size_t k, bool termOverLimit = false) noexcept;
+    char_parsers::UChar nextChar() noexcept;
+    char_parsers::UChar skipBlanks() noexcept;
+    void trimText() noexcept;
+    char_parsers::UChar seekBrace(char c, bool appendFound) noexcept;
+    char_parsers::UChar appendBounded(char c, bool appendFound) noexcept;
+    ItemType loadCDATA() noexcept;
+    void cutPartial(ItemType type) noexcept;
+    bool unescape(std::string_view src, std::pmr::string& dst) noexcept;
+    bool expandEntity(Entity& e) noexcept;
+    bool declareEntities() noexcept;
+    void declareEntity(std::string_view decl) noexcept;
+    void addEntity(std::string_view name, std::string_view value) noexcept;
+    void clearEntities() noexcept;
     bool appendRestOfPI() noexcept;
     bool appendRestOfComment() noexcept;
     bool appendRestOfCDATA() noexcept;
+    bool appendRestOfDeclaration() noexcept;
     ItemType loadTag() noexcept;
+    ItemType loadStartTag(char_parsers::UChar c) noexcept;
+    bool skipRestOfTag(char& last) noexcept;
     ItemType loadText() noexcept;
 
 };
+
+template<class F>
+void XmlParser::Path::reference::forEachAttribute(F f) const noexcept
+{
+    char_parsers::charser it(*this);
+    while(it.seek(char_parsers::lt_eq(' ')) && it.seek(char_parsers::gt(' '))) // "[blanks...][non-blank]"
+    {
+        char_parsers::charser name;
+        if(!it.seek_span('=', true, name)) break;
+        std::string_view n = name;
+        while (!n.empty() && static_cast<unsigned char>(n.back()) <= ' ') n.remove_suffix(1); // "name ="
+        if (!it.seek(char_parsers::gt(' '))) break; // "= value"
+        auto q = it.getc(); // leading quote; the value ends at the same one
+        if (q != '"' && q != '\'') break;
+        char_parsers::charser value;
+        if (!it.seek_span(static_cast<char>(q), true, value)) break;
+        f(Attribute{n, value});
+    }
+}
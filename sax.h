@@ -0,0 +1,111 @@
+#pragma once
+
+// Push (SAX) processing with handlers bound at compile time.
+
+#include "processor.h"
+#include <type_traits>
+
+/// Base of SAX handlers; the derived class overrides the callbacks it needs
+/// by hiding them with members of the same signature (CRTP), so that calls
+/// are resolved at compile time and can be inlined. Item types which have no
+/// callback in the derived class are skipped by the parser without being
+/// loaded into its text buffer, as are those of the parser's skip mask.
+/// \tparam D The derived class.
+///
+///     struct Counter : XmlSaxHandler<Counter>
+///     {
+///         std::size_t n = 0;
+///         void onStart(const XmlParser&) noexcept { ++n; }
+///     };
+///     ...
+///     Counter c;
+///     if (p.openFile(path) && c.parse(p)) ...
+template<class D>
+class XmlSaxHandler
+{
+    public:
+
+    /// Called for start-tags and self-closing elements; getLevel(), getName()
+    /// and attributes refer to the element.
+    void onStart(const XmlParser&) noexcept {}
+
+    /// Called for end-tags and, after onStart(), for self-closing elements.
+    void onEnd(const XmlParser&) noexcept {}
+
+    /// Called for text blocks.
+    void onText(const XmlParser&) noexcept {}
+
+    /// Called for CDATA blocks.
+    void onCData(const XmlParser&) noexcept {}
+
+    /// Called for processing instructions.
+    void onPI(const XmlParser&) noexcept {}
+
+    /// Called for comments.
+    void onComment(const XmlParser&) noexcept {}
+
+    /// Called for DTD's.
+    void onDTD(const XmlParser&) noexcept {}
+
+    /// Processes the rest of the file opened by the parser, pushing the items
+    /// to the callbacks of the derived class.
+    /// \return False on parsing error.
+    bool parse(XmlParser& parser) noexcept
+    {
+        auto mask = parser.getSkipMask();
+        parser.setSkipMask(mask | skip_mask);
+        auto& d = static_cast<D&>(*this);
+        while (parser.next())
+        {
+            switch (parser.getItemType())
+            {
+            case XmlParser::ItemType::kPrefix:
+                d.onStart(parser);
+                break;
+            case XmlParser::ItemType::kSelfClosing:
+                d.onStart(parser);
+                d.onEnd(parser);
+                break;
+            case XmlParser::ItemType::kSuffix:
+                d.onEnd(parser);
+                break;
+            case XmlParser::ItemType::kEscapedText:
+                if constexpr (has_text) d.onText(parser);
+                break;
+            case XmlParser::ItemType::kCData:
+                if constexpr (has_cdata) d.onCData(parser);
+                break;
+            case XmlParser::ItemType::kPI:
+                if constexpr (has_pi) d.onPI(parser);
+                break;
+            case XmlParser::ItemType::kComment:
+                if constexpr (has_comment) d.onComment(parser);
+                break;
+            case XmlParser::ItemType::kDTD:
+                if constexpr (has_dtd) d.onDTD(parser);
+                break;
+            default:
+                break;
+            }
+        }
+        parser.setSkipMask(mask);
+        return !parser.error();
+    }
+
+    private:
+
+    using B = XmlSaxHandler;
+    using T = XmlParser::ItemType;
+
+    static constexpr bool has_text = !std::is_same_v<decltype(&D::onText), decltype(&B::onText)>;
+    static constexpr bool has_cdata = !std::is_same_v<decltype(&D::onCData), decltype(&B::onCData)>;
+    static constexpr bool has_pi = !std::is_same_v<decltype(&D::onPI), decltype(&B::onPI)>;
+    static constexpr bool has_comment = !std::is_same_v<decltype(&D::onComment), decltype(&B::onComment)>;
+    static constexpr bool has_dtd = !std::is_same_v<decltype(&D::onDTD), decltype(&B::onDTD)>;
+
+    // items without callbacks; elements are never skipped as they form the path
+    static constexpr int skip_mask =
+        (has_text ? 0 : (int)T::kEscapedText) | (has_cdata ? 0 : (int)T::kCData) |
+        (has_pi ? 0 : (int)T::kPI) | (has_comment ? 0 : (int)T::kComment) |
+        (has_dtd ? 0 : (int)T::kDTD);
+};
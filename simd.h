@@ -0,0 +1,202 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CHARSER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace char_parsers
+{
+
+/// \brief Vectorized byte-scanning helpers; fall back to plain loops
+/// where SSE2 is not available.
+namespace simd
+{
+
+/// Index of the lowest set bit; the value must not be zero.
+inline unsigned ctz(std::uint32_t v) noexcept
+{
+#ifdef _MSC_VER
+	unsigned long i;
+	_BitScanForward(&i, v);
+	return i;
+#else
+	return __builtin_ctz(v);
+#endif
+}
+
+/// Index of the lowest set bit of a 64-bit value; the value must not be zero.
+inline unsigned ctz64(std::uint64_t v) noexcept
+{
+	auto lo = static_cast<std::uint32_t>(v);
+	return lo ? ctz(lo) : 32 + ctz(static_cast<std::uint32_t>(v >> 32));
+}
+
+/// \brief Set of up to 8 bytes to search for.
+struct byte_set
+{
+	constexpr byte_set(std::initializer_list<char> l) noexcept : chars{}, n(0)
+	{
+		for (auto c : l) if (n < 8) chars[n++] = c;
+	}
+
+	constexpr bool contains(char c) const noexcept
+	{
+		for (int i = 0; i != n; ++i) if (chars[i] == c) return true;
+		return false;
+	}
+
+	char chars[8];
+	int n;
+};
+
+/// \brief Finds the first byte which is in a set.
+/// \return Pointer to the byte found or end.
+inline const char* find_first_of(const char* p, const char* end, const byte_set& set) noexcept
+{
+#ifdef CHARSER_SSE2
+	__m128i v[8];
+	for (int i = 0; i != set.n; ++i) v[i] = _mm_set1_epi8(set.chars[i]);
+	for (; end - p >= 16; p += 16)
+	{
+		__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		__m128i m = _mm_cmpeq_epi8(x, v[0]);
+		for (int i = 1; i < set.n; ++i) m = _mm_or_si128(m, _mm_cmpeq_epi8(x, v[i]));
+		auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(m));
+		if (mask) return p + ctz(mask);
+	}
+#endif
+	for (; p != end; ++p) if (set.contains(*p)) return p;
+	return end;
+}
+
+/// \brief Finds the first byte which is not an XML blank, i.e. above ' '.
+/// \return Pointer to the byte found or end.
+inline const char* find_non_blank(const char* p, const char* end) noexcept
+{
+#ifdef CHARSER_SSE2
+	const __m128i space = _mm_set1_epi8(' ');
+	for (; end - p >= 16; p += 16)
+	{
+		__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		// unsigned x <= ' ' if max(x, ' ') == ' '
+		__m128i blank = _mm_cmpeq_epi8(_mm_max_epu8(x, space), space);
+		auto mask = ~static_cast<std::uint32_t>(_mm_movemask_epi8(blank)) & 0xFFFF;
+		if (mask) return p + ctz(mask);
+	}
+#endif
+	for (; p != end; ++p) if (static_cast<unsigned char>(*p) > ' ') return p;
+	return end;
+}
+
+/// \brief Finds the first occurrence of a string, e.g. a terminator as "-->".
+/// Candidates are found by the first and the last byte of the string, 16 
+/// positions at a time, and then compared.
+/// \return Pointer to the occurrence or end.
+inline const char* find_string(const char* p, const char* end, const char* s, std::size_t m) noexcept
+{
+	if (m == 0) return p;
+	if (static_cast<std::size_t>(end - p) < m) return end;
+	if (m == 1)
+	{
+		auto f = static_cast<const char*>(memchr(p, s[0], end - p));
+		return f ? f : end;
+	}
+	const char* last = end - m;  // the last possible start
+#ifdef CHARSER_SSE2
+	const __m128i first = _mm_set1_epi8(s[0]), tail = _mm_set1_epi8(s[m - 1]);
+	for (; last - p >= 15; p += 16)
+	{
+		__m128i x0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		__m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + m - 1));
+		auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(
+			_mm_and_si128(_mm_cmpeq_epi8(x0, first), _mm_cmpeq_epi8(x1, tail))));
+		for (; mask; mask &= mask - 1)
+		{
+			auto q = p + ctz(mask);
+			if (memcmp(q + 1, s + 1, m - 2) == 0) return q;
+		}
+	}
+#endif
+	for (; p <= last; ++p) if (p[0] == s[0] && memcmp(p + 1, s + 1, m - 1) == 0) return p;
+	return end;
+}
+
+/// \brief Finds the first byte which is not ASCII, i.e. above 0x7F.
+/// \return Pointer to the byte found or end.
+inline const char* find_non_ascii(const char* p, const char* end) noexcept
+{
+#ifdef CHARSER_SSE2
+	for (; end - p >= 16; p += 16)
+	{
+		__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(x));
+		if (mask) return p + ctz(mask);
+	}
+#endif
+	for (; p != end; ++p) if (static_cast<unsigned char>(*p) >= 0x80) return p;
+	return end;
+}
+
+/// \brief Number of UTF-8 code points, i.e. of bytes other than continuation
+/// ones (10xxxxxx).
+inline std::size_t count_utf8(const char* p, const char* end) noexcept
+{
+	std::size_t n = 0;
+#ifdef CHARSER_SSE2
+	const __m128i last_continuation = _mm_set1_epi8(-65);  // 0xBF; signed comparison
+	const __m128i zero = _mm_setzero_si128();
+	while (end - p >= 16)
+	{
+		// per-byte counters, summed before they can overflow
+		__m128i counts = zero;
+		auto nBlocks = std::min<std::size_t>((end - p) / 16, 255);
+		for (; nBlocks; --nBlocks, p += 16)
+		{
+			__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			counts = _mm_sub_epi8(counts, _mm_cmpgt_epi8(x, last_continuation));
+		}
+		__m128i sums = _mm_sad_epu8(counts, zero);
+		n += _mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4);
+	}
+#endif
+	for (; p != end; ++p) n += (static_cast<unsigned char>(*p) & 0xC0) != 0x80;
+	return n;
+}
+
+/// \brief Copies the leading run of ASCII bytes to UTF-32 code points.
+/// \return Number of bytes copied.
+inline std::size_t widen_ascii(const char* p, const char* end, char32_t* dst) noexcept
+{
+	auto b = p;
+#ifdef CHARSER_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	for (; end - p >= 16; p += 16, dst += 16)
+	{
+		__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		if (_mm_movemask_epi8(x)) break;
+		__m128i lo = _mm_unpacklo_epi8(x, zero), hi = _mm_unpackhi_epi8(x, zero);
+		auto d = reinterpret_cast<__m128i*>(dst);
+		_mm_storeu_si128(d, _mm_unpacklo_epi16(lo, zero));
+		_mm_storeu_si128(d + 1, _mm_unpackhi_epi16(lo, zero));
+		_mm_storeu_si128(d + 2, _mm_unpacklo_epi16(hi, zero));
+		_mm_storeu_si128(d + 3, _mm_unpackhi_epi16(hi, zero));
+	}
+#endif
+	for (; p != end && static_cast<unsigned char>(*p) < 0x80; ++p) *dst++ = static_cast<char32_t>(*p);
+	return p - b;
+}
+
+} // end namespace simd
+
+}; // end namespace
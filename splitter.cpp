@@ -0,0 +1,124 @@
+#include "splitter.h"
+#include <algorithm>
+#include <functional>
+#include <memory>
+
+XmlSplitter::XmlSplitter(std::size_t bufferSize) noexcept :
+    _parser(bufferSize),
+    _level(2),
+    _nThreads(1),
+    _nRecords(0)
+{
+}
+
+bool XmlSplitter::isRecord() const noexcept
+{
+    return _parser.isElement() && (!_level || _parser.getLevel() == _level) &&
+        (_name.empty() || _parser.getName() == _name);
+}
+
+std::size_t XmlSplitter::getShard(std::size_t nShards) const noexcept
+{
+    std::string_view key;
+    _parser.getStartTag().forEachAttribute([this, &key](const XmlParser::Attribute& a)
+    {
+        if (a.name == _key) key = a.value;
+    });
+    return std::hash<std::string_view>()(key) % nShards;
+}
+
+std::string_view XmlSplitter::getStartTag() noexcept
+{
+    // the declarations of the elements between the root and the record, the 
+    // innermost of each prefix; none of those the record declares itself
+    auto isDeclaration = [](const XmlParser::Attribute& a)
+    {
+        return a.name == "xmlns" || a.name.substr(0, 6) == "xmlns:";
+    };
+    std::vector<std::string_view> declared;
+    _parser.getStartTag().forEachAttribute([&](const XmlParser::Attribute& a)
+    {
+        if (isDeclaration(a)) declared.push_back(a.name);
+    });
+    auto& path = _parser.getPath();
+    auto tag = _parser.getStartTag();
+    auto nameEnd = 1 + _parser.getName().size();
+    _startTag.assign(tag.substr(0, nameEnd));
+    for (auto level = _parser.getLevel() - 1; level > 1; --level)
+    {
+        path[level].forEachAttribute([&](const XmlParser::Attribute& a)
+        {
+            if (!isDeclaration(a) || std::find(declared.begin(), declared.end(), a.name) != declared.end()) return;
+            declared.push_back(a.name);
+            char quote = a.value.find('"') == a.value.npos ? '"' : '\'';
+            _startTag.append(" ").append(a.name).append("=") += quote;
+            _startTag.append(a.value) += quote;
+        });
+    }
+    if (_startTag.size() == nameEnd) return {};
+    return _startTag.append(tag.substr(nameEnd));
+}
+
+bool XmlSplitter::split(const char* input, const std::vector<std::string>& outputs) noexcept
+{
+    _nRecords = 0;
+    auto nShards = outputs.size();
+    if (!nShards || _level == 1 || (!_level && _name.empty())) return false;
+
+    // shard s is written by the group s % nGroups, as its file s / nGroups
+    auto nGroups = std::min(_nThreads, nShards);
+    std::vector<std::unique_ptr<BatchFileWriter> > writers;
+    for (std::size_t g = 0; g != nGroups; ++g) writers.emplace_back(new BatchFileWriter());
+    for (std::size_t s = 0; s != nShards; ++s)
+    {
+        if (!writers[s % nGroups]->openFile(outputs[s].c_str())) return false;
+    }
+    if (!_parser.openFile(input)) return false;
+    for (auto& w : writers) w->startThread();
+
+    auto writeAll = [&](std::string_view data)
+    {
+        for (std::size_t s = 0; s != nShards; ++s) writers[s % nGroups]->write(data, s / nGroups);
+    };
+
+    // prolog and the root's start-tag
+
+    std::string rootName;
+    while (_parser.next())
+    {
+        writeAll(_parser.getText());
+        if (_parser.isElement())
+        {
+            if (_parser.isPrefix()) rootName = _parser.getName();
+            break;
+        }
+        writeAll("\n");
+    }
+
+    // records
+
+    std::size_t iNext = 0;
+    while (_parser.next(1))
+    {
+        if (!isRecord()) continue;
+        auto s = _key.empty() ? iNext++ % nShards : getShard(nShards);
+        if (!_parser.copyElement(*writers[s % nGroups], s / nGroups, getStartTag())) break;
+        ++_nRecords;
+    }
+
+    if (!rootName.empty())
+    {
+        writeAll("</");
+        writeAll(rootName);
+        writeAll(">\n");
+    }
+
+    bool ok = !_parser.error() && !_parser.isEnd();
+    _parser.closeFile();
+    for (auto& w : writers)
+    {
+        ok &= w->flush();
+        w->closeFiles();
+    }
+    return ok;
+}
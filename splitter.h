@@ -0,0 +1,69 @@
+#pragma once
+
+#include "batchwriter.h"
+#include <string>
+
+/// Splits a document into shards holding whole records.
+/// \detail The input is read once. Records are elements at a given level
+/// (2 by default, i.e. the children of the root element), optionally of a
+/// given name. Each record is copied as is, directly from the read buffer,
+/// to a shard chosen either round-robin or by the hash of a key attribute.
+/// Every shard gets the original prolog (the items preceding the root
+/// element) and the root element's start- and end-tag, so that it is a
+/// well-formed document itself. Records below the children of the root get
+/// the namespace declarations of the elements around them, as those are not
+/// copied. Anything at the record level which is not a record is dropped. 
+/// Shards are divided into groups, each written by its own thread.
+class XmlSplitter
+{
+    public:
+
+    /// Constructor.
+    ///\ param bufferSize Size of the parser's file buffer.
+    XmlSplitter(std::size_t bufferSize = XmlParser::default_chunk_size) noexcept;
+
+    /// Gets and sets the level of records; 0 means any level, which
+    /// requires the record name to be set.
+    std::size_t getRecordLevel() const noexcept { return _level; }
+    void setRecordLevel(std::size_t v) noexcept { _level = v; }
+
+    /// Gets and sets the name of records; empty means any name.
+    const std::string& getRecordName() const noexcept { return _name; }
+    void setRecordName(std::string_view v) noexcept { _name = v; }
+
+    /// Gets and sets the key attribute; if set, a record goes to the shard
+    /// chosen by the hash of this attribute's value, otherwise round-robin.
+    const std::string& getKeyAttribute() const noexcept { return _key; }
+    void setKeyAttribute(std::string_view v) noexcept { _key = v; }
+
+    /// Gets and sets the number of writing threads.
+    std::size_t getThreadCount() const noexcept { return _nThreads; }
+    void setThreadCount(std::size_t v) noexcept { _nThreads = std::max<std::size_t>(v, 1); }
+
+    /// Splits a file.
+    /// \param input Full path to the file.
+    /// \param outputs Full paths to the shards to create.
+    /// \return False if any file could not be opened, read or written,
+    /// or data error occured.
+    bool split(const char* input, const std::vector<std::string>& outputs) noexcept;
+
+    /// Gets the parser's error after split().
+    XmlParser::ErrorCode getErrorCode() const noexcept { return _parser.getErrorCode(); }
+
+    /// Gets the number of records written by split().
+    std::size_t getRecordCount() const noexcept { return _nRecords; }
+
+    private:
+
+    XmlParser _parser;
+    std::size_t _level;
+    std::string _name;
+    std::string _key;
+    std::size_t _nThreads;
+    std::size_t _nRecords;
+    std::string _startTag;  // of the current record, with declarations added
+
+    bool isRecord() const noexcept;
+    std::string_view getStartTag() noexcept;
+    std::size_t getShard(std::size_t nShards) const noexcept;
+};
@@ -0,0 +1,73 @@
+#include "structural.h"
+#include "simd.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace char_parsers;
+
+StructuralIndex::BlockMasks StructuralIndex::classify(const char* p, std::size_t n) noexcept
+{
+    char tmp[block_size];
+    if (n < block_size) // pad the tail
+    {
+        memcpy(tmp, p, n);
+        memset(tmp + n, ' ', block_size - n);
+        p = tmp;
+    }
+    BlockMasks m = {};
+#ifdef CHARSER_SSE2
+    const __m128i lt = _mm_set1_epi8('<'), gt = _mm_set1_epi8('>');
+    for (int i = 0; i != 4; ++i)
+    {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i * 16));
+        auto bits = [i](__m128i eq)
+        {
+            return static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(eq))) << (i * 16);
+        };
+        m.lt |= bits(_mm_cmpeq_epi8(x, lt));
+        m.gt |= bits(_mm_cmpeq_epi8(x, gt));
+    }
+#else
+    for (std::size_t i = 0; i != block_size; ++i)
+    {
+        auto bit = std::uint64_t(1) << i;
+        if (p[i] == '<') m.lt |= bit;
+        else if (p[i] == '>') m.gt |= bit;
+    }
+#endif
+    return m;
+}
+
+void StructuralIndex::build(const char* p, std::size_t n) noexcept
+{
+    _begin = p;
+    _chunkEnd = p + n;
+    n = std::min(n, max_size);
+    _end = p + n;
+    _cursor = 0;
+    _positions.clear();
+    for (std::size_t i = 0; i < n; i += block_size)
+    {
+        auto m = classify(p + i, std::min(block_size, n - i));
+        for (auto bits = m.lt | m.gt; bits; bits &= bits - 1)
+        {
+            _positions.push_back(static_cast<std::uint32_t>(i + simd::ctz64(bits)));
+        }
+    }
+}
+
+const char* StructuralIndex::find(const char* p, char c) noexcept
+{
+    auto offset = static_cast<std::uint32_t>(p - _begin);
+    if (_cursor && _positions[_cursor - 1] >= offset) // moved back
+    {
+        _cursor = std::lower_bound(_positions.begin(), _positions.end(), offset) - _positions.begin();
+    }
+    while (_cursor != _positions.size() && _positions[_cursor] < offset) ++_cursor;
+    for (auto i = _cursor; i != _positions.size(); ++i)
+    {
+        auto found = _begin + _positions[i];
+        if (!c || *found == c) return found;
+    }
+    return _end;
+}
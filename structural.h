@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// Structural index of a chunk of XML data.
+/// \detail Stage 1 of a two-stage scan: each 64-byte block is classified
+/// into bitmasks of the tag braces, and their positions are collected into
+/// an array. Stage 2 is XmlParser walking this array instead of testing
+/// every character when it looks for the end of a text block or a tag 
+/// (see XmlParser::Options::kStructuralIndex). Quotes are not tracked: 
+/// the parser looks for the braces themselves, as its plain scan does.
+class StructuralIndex
+{
+    public:
+
+    static constexpr std::size_t block_size = 64;
+
+    /// Longest part of a chunk indexed at once, as positions are 32-bit.
+    static constexpr std::size_t max_size = UINT32_MAX;
+
+    /// Bitmasks of a block: bit i is set if character i is of the class.
+    struct BlockMasks
+    {
+        std::uint64_t lt;        // '<'
+        std::uint64_t gt;        // '>'
+    };
+
+    /// Classifies a block.
+    /// \param p Block data; if n < block_size, the rest is treated as blanks.
+    static BlockMasks classify(const char* p, std::size_t n = block_size) noexcept;
+
+    /// Builds the index of a chunk, or of its first max_size bytes (see end());
+    /// the data must stay in memory while the index is used.
+    void build(const char* p, std::size_t n) noexcept;
+
+    /// Invalidates the index.
+    void clear() noexcept { _begin = _end = _chunkEnd = 0; _positions.clear(); _cursor = 0; }
+
+    /// True if the index is built for a chunk at given bounds, and covers 
+    /// the data at begin.
+    bool isBuilt(const char* begin, const char* end) const noexcept
+    { return _begin && begin >= _begin && begin < _end && end == _chunkEnd; }
+
+    /// End of the indexed part of the chunk.
+    const char* end() const noexcept { return _end; }
+
+    /// Finds the first brace at or after a position.
+    /// \param p The position; searches are fast while p does not decrease.
+    /// \param c '<' or '>' or 0 for any of them.
+    /// \return Pointer to the brace or end().
+    const char* find(const char* p, char c) noexcept;
+
+    private:
+
+    const char* _begin = 0;
+    const char* _end = 0;
+    const char* _chunkEnd = 0;
+    std::vector<std::uint32_t> _positions;  // offsets of '<' and '>'
+    std::size_t _cursor = 0;  // the first position not behind the last search
+};
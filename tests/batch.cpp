@@ -0,0 +1,74 @@
+// XmlParser::nextBatch(): the arrays hold what next() gives item by item, for
+// a file, a buffer and a stream, whatever the batch size.
+
+#include "test.h"
+
+namespace
+{
+    std::string dumpBatches(XmlParser& p, std::size_t n, std::string_view feed = {})
+    {
+        XmlParser::TokenBatch batch;
+        std::string s;
+        for (;;)
+        {
+            if (!p.nextBatch(batch, n))
+            {
+                if (!p.needsInput()) break;
+                auto piece = feed.substr(0, 7);  // a stream in small pieces
+                feed.remove_prefix(piece.size());
+                if (piece.empty()) p.finish();
+                else p.feed(piece.data(), piece.size());
+                continue;
+            }
+            CHECK(batch.size() <= n);
+            for (std::size_t i = 0; i != batch.size(); ++i)
+            {
+                s += std::to_string((int)batch.types[i]) + ' ' + std::to_string(batch.levels[i]) + ' ';
+                s.append(batch.getName(i)).append(": ").append(batch.getText(i)) += '\n';
+                CHECK(batch.names[batch.nameIds[i]] == batch.getName(i));
+            }
+        }
+        return s + "error " + std::to_string((int)p.getErrorCode());
+    }
+}
+
+int main()
+{
+    std::string xml = "<?xml version=\"1.0\"?><root>";
+    for (int i = 0; i != 50; ++i)
+    {
+        xml += "<item n='" + std::to_string(i) + "'>text " + std::to_string(i) + "<!--c--><sub/></item>";
+    }
+    xml += "</root>";
+    auto path = test::writeFile("batch.xml", xml);
+    auto expected = test::dump(xml);
+
+    for (std::size_t n : { 1, 3, 1000 })
+    {
+        XmlParser p;
+        p.openFile(path);
+        CHECK(dumpBatches(p, n) == expected);
+        p.openBuffer(xml.data(), xml.size());
+        CHECK(dumpBatches(p, n) == expected);
+        p.openStream();
+        CHECK(dumpBatches(p, n, xml) == expected);
+    }
+
+    // IDs stay the same from batch to batch
+    XmlParser p;
+    p.openBuffer(xml.data(), xml.size());
+    XmlParser::TokenBatch batch;
+    CHECK(p.nextBatch(batch, 3) == 3);
+    auto itemId = batch.getNameId("item");
+    while (p.nextBatch(batch, 5)) {}
+    CHECK(batch.empty() && batch.getNameId("item") == itemId);
+    CHECK(batch.names.size() == 4);  // "", root, item, sub
+
+    // all items at once, more than the arrays are sized for at first
+    std::string big = "<root>";
+    for (int i = 0; i != 2000; ++i) big += "<a>x<b/></a>";
+    big += "</root>";
+    p.openBuffer(big.data(), big.size());
+    CHECK(dumpBatches(p, SIZE_MAX) == test::dump(big));
+    return test::result();
+}
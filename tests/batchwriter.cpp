@@ -0,0 +1,35 @@
+// BatchFileWriter: interleaved writes to several files, of sizes around the
+// block and batch sizes, come out in order, with and without the thread.
+
+#include "test.h"
+#include "../batchwriter.h"
+
+int main()
+{
+    for (bool threaded : { false, true })
+    {
+        std::string expected[3];
+        {
+            BatchFileWriter w(64, 16);
+            CHECK(w.openFiles({ "batch0.txt", "batch1.txt", "batch2.txt" }) && w.size() == 3);
+            if (threaded) w.startThread(2);
+            for (std::size_t i = 0; i != 300; ++i)
+            {
+                // 1 to 99 bytes: within a block, across blocks, over the batch size
+                std::string s(i % 99 + 1, char('a' + i % 26));
+                auto iFile = i % 3;
+                w.write(s, iFile);
+                expected[iFile] += s;
+                if (i == 150) CHECK(w.flush());
+            }
+            CHECK(!w.error());
+        }
+        CHECK(test::readFile("batch0.txt") == expected[0]);
+        CHECK(test::readFile("batch1.txt") == expected[1]);
+        CHECK(test::readFile("batch2.txt") == expected[2]);
+    }
+
+    BatchFileWriter w;
+    CHECK(!w.openFiles({ "batch0.txt", "no such dir/batch.txt" }) && w.size() == 0);
+    return test::result();
+}
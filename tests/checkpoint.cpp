@@ -0,0 +1,51 @@
+// saveState() and restoreState(): a parse resumed from any item goes on as
+// the uninterrupted one.
+
+#include "test.h"
+
+int main()
+{
+    auto path = test::writeFile("checkpoint.xml",
+        "<?xml version=\"1.0\"?>\n"
+        "<!DOCTYPE r [<!ENTITY who \"world\">]>\n"
+        "<r a=\"1\">\n"
+        "  <item id='1'>hello &who;</item>\n"
+        "  <!-- note -->\n"
+        "  <item id='2'><sub>deep</sub><empty/></item>\n"
+        "</r>\n");
+    const int options = XmlParser::Options::kUnescapeText;
+
+    XmlParser whole;
+    whole.setOptions(options);
+    CHECK(whole.saveState().empty());  // no file
+    CHECK(whole.openFile(path));
+    std::size_t nItems = 0;
+    while (whole.next()) ++nItems;
+    CHECK(nItems > 10 && !whole.error());
+
+    for (std::size_t k = 1; k < nItems; ++k)
+    {
+        XmlParser p;
+        p.setOptions(options);
+        CHECK(p.openFile(path));
+        for (std::size_t i = 0; i != k; ++i) CHECK(p.next());
+        auto state = p.saveState();
+        CHECK(!state.empty());
+        auto level = p.getLevel();
+
+        XmlParser q;
+        CHECK(q.restoreState(path, state));
+        CHECK(q.getOptions() == options);
+        CHECK(q.getLevel() == level);
+        CHECK(test::dump(q) == test::dump(p));
+    }
+
+    XmlParser p;
+    CHECK(p.openFile(path) && p.next() && p.next());
+    auto state = p.saveState();
+    XmlParser q;
+    CHECK(!q.restoreState(path, "not a state"));
+    CHECK(!q.restoreState("no such file.xml", state));
+    CHECK(q.restoreState(path, state));
+    return test::result();
+}
@@ -0,0 +1,74 @@
+// Entities declared in the internal DTD subset: expanded in texts, also when
+// the DTD is skipped, and bounded by Limits::maxEntityExpansion.
+
+#include "test.h"
+
+namespace
+{
+    /// The text of the root element, or "error N".
+    std::string rootText(std::string_view xml, const XmlParser::Limits& limits = {}, int skipMask = 0)
+    {
+        XmlParser p;
+        p.setOptions(XmlParser::Options::kUnescapeText);
+        p.setLimits(limits);
+        p.setSkipMask(skipMask);
+        p.openBuffer(xml.data(), xml.size());
+        std::string s;
+        while (p.next())
+        {
+            if (p.isText()) s.append(p.getText());
+        }
+        return p.error() ? "error " + std::to_string((int)p.getErrorCode()) : s;
+    }
+}
+
+int main()
+{
+    std::string_view xml =
+        "<!DOCTYPE r [\n"
+        "  <!ENTITY a \"A>\">\n"
+        "  <!ENTITY a 'second'>\n"
+        "  <!ENTITY b \"[&a;&a;]\">\n"
+        "  <!ENTITY % p \"P\">\n"
+        "  <!ENTITY ext SYSTEM \"x.ent\">\n"
+        "]><r>&a;&b; &p; &ext; &amp;&#65;&#x42; &unknown; &</r>";
+    const std::string expected = "A>[A>A>] &p; &ext; &AB &unknown; &";
+    CHECK(rootText(xml) == expected);
+    CHECK(rootText(xml, {}, (int)XmlParser::ItemType::kDTD) == expected);
+
+    // the whole DTD is one item, '>' in values included
+    XmlParser p;
+    p.openBuffer(xml.data(), xml.size());
+    CHECK(p.next() && p.getItemType() == XmlParser::ItemType::kDTD && p.getText().ends_with("]>"));
+    CHECK(p.next() && p.isElement("r"));
+
+    // recursion, and growth beyond the limit
+    const std::string error = "error " + std::to_string((int)XmlParser::ErrorCode::kErrEntity);
+    CHECK(rootText("<!DOCTYPE r [<!ENTITY a \"&b;\"><!ENTITY b \"&a;\">]><r>&a;</r>") == error);
+    CHECK(rootText("<!DOCTYPE r [<!ENTITY a \"x&a;\">]><r>&a;</r>") == error);
+    std::string laughs = "<!DOCTYPE r [<!ENTITY l0 \"lol\">";
+    for (int i = 1; i != 10; ++i)
+    {
+        laughs += "<!ENTITY l" + std::to_string(i) + " \"";
+        for (int k = 0; k != 10; ++k) laughs += "&l" + std::to_string(i - 1) + ";";
+        laughs += "\">";
+    }
+    laughs += "]><r>&l9;</r>";
+    CHECK(rootText(laughs) == error);
+    XmlParser::Limits limits;
+    limits.maxEntityExpansion = 100;
+    std::string grows = "<!DOCTYPE r [<!ENTITY d \"0123456789\">]><r>", digits;
+    for (int i = 0; i != 11; ++i)
+    {
+        grows += "&d;";
+        digits += "0123456789";
+    }
+    grows += "</r>";
+    CHECK(rootText(grows) == digits);
+    CHECK(rootText(grows, limits) == error);
+    auto longValue = "<!DOCTYPE r [<!ENTITY d \"" + std::string(101, 'x') + "\">]><r/>";
+    CHECK(rootText(longValue, limits) == error);
+    longValue.replace(longValue.find('x'), 1, "");
+    CHECK(rootText(longValue, limits).empty());
+    return test::result();
+}
@@ -0,0 +1,63 @@
+// FileReader policies: whatever the combination, read() and seek() give the
+// bytes of the file, and the parser the same items.
+
+#include "test.h"
+
+namespace
+{
+    /// Reads the rest of the file.
+    std::string readAll(FileReader& r)
+    {
+        std::string s;
+        for (std::size_t n; (n = r.read()); ) s.append(r.data(), n);
+        return s;
+    }
+}
+
+int main()
+{
+    std::string data;
+    for (std::uint32_t i = 0, x = 1; data.size() < 0x50000 + 123; ++i)
+    {
+        x = x * 1103515245 + 12345;
+        data += char(x >> 24);
+    }
+    auto path = test::writeFile("filereader.bin", data);
+    std::string xml = "<r>";
+    for (int i = 0; i != 10000; ++i) xml += "<i n='" + std::to_string(i) + "'>t</i>";
+    xml += "</r>";
+    auto xmlPath = test::writeFile("filereader.xml", xml);
+    auto expected = test::dump(xml);
+
+    using P = FileReader::Policy;
+    const int policies[] = { P::kDefault, P::kHugePages, P::kSequential, P::kAdaptive, P::kFastStart,
+        P::kDirect, P::kAdaptive | P::kFastStart, P::kHugePages | P::kSequential | P::kAdaptive | P::kFastStart | P::kDirect };
+    for (auto policy : policies)
+    {
+        FileReader r(0x10000);
+        r.setPolicy(policy);
+        CHECK(r.capacity() >= 0x10000 && r.capacity() % FileReader::page_size == 0);
+        CHECK(!r.isOpen() && r.open(path) && r.isOpen() && r.size() == data.size());
+        auto n = r.read();
+        if ((policy & P::kFastStart) && data.size() > r.capacity()) CHECK(n == FileReader::first_read_size);
+        CHECK(n && n <= r.capacity() && data.compare(0, n, r.data(), n) == 0);
+        CHECK(data.substr(n) == readAll(r) && !r.error());
+
+        for (std::uint64_t pos : { 0x12345, 0x1000, 0x4ffff, 0x50000 + 123 })
+        {
+            CHECK(r.seek(pos) && data.substr(pos) == readAll(r));
+        }
+        r.close();
+        CHECK(!r.isOpen() && !r.open("no such file.bin"));
+
+        XmlParser p(0x10000);
+        p.setReadPolicy(policy);
+        CHECK(p.openFile(xmlPath) && test::dump(p) == expected);
+    }
+
+    // a file which fits in the buffer is read at once
+    FileReader r(0x100000);
+    r.setPolicy(P::kFastStart | P::kAdaptive);
+    CHECK(r.open(path) && r.read() == data.size() && r.read() == 0);
+    return test::result();
+}
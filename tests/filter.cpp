@@ -0,0 +1,79 @@
+// addElementFilter(): other elements are loaded as bare tags with their texts
+// skipped, nested elements of interest in full, the same from any input.
+
+#include "test.h"
+
+namespace
+{
+    std::string dumpFiltered(std::string_view xml, int options = 0)
+    {
+        XmlParser p;
+        p.setOptions(options);
+        p.addElementFilter("y");
+        p.addElementFilter("y");
+        p.openBuffer(xml.data(), xml.size());
+        return test::dump(p);
+    }
+}
+
+int main()
+{
+    std::string_view xml =
+        "<r><x a='1' b=\"a/b\">tx<y\n c=\"3\">ty<z q='/'/>tz</y>tx2<![CDATA[c]]></x><y/><p:y/></r>";
+    CHECK(dumpFiltered(xml) ==
+        "1 1 r: <r>\n"
+        "1 2 x: <x>\n"
+        "1 3 y: <y\n c=\"3\">\n"
+        "8 3 y: ty\n"
+        "4 4 z: <z/>\n"
+        "8 3 y: tz\n"
+        "2 3 y: </y>\n"
+        "2 2 x: </x>\n"
+        "4 2 y: <y/>\n"
+        "4 2 p:y: <p:y/>\n"
+        "2 1 r: </r>\n"
+        "error 0");
+    // tags in full with namespaces, as they may declare some
+    std::string_view nsXml = "<r xmlns:p='urn:p'><p:x a='1'>t</p:x></r>";
+    CHECK(dumpFiltered(nsXml, XmlParser::Options::kNamespaces).find("<p:x a='1'>") != std::string::npos);
+
+    XmlParser p;
+    p.addElementFilter("y");
+    p.openBuffer(xml.data(), xml.size());
+    CHECK(p.next() && !p.isElementOfInterest() && p.next() && p.next() && p.isElementOfInterest());
+    p.clearElementFilter();
+    p.openBuffer(xml.data(), xml.size());
+    CHECK(test::dump(p) == test::dump(xml));
+
+    // across chunks of a file and pieces of a stream
+    std::string big = "<r>";
+    for (int i = 0; i != 3000; ++i)
+    {
+        big += "<x n='" + std::to_string(i) + "' pad='" + std::string(i % 50, '.') + "'>skipped " +
+            std::to_string(i) + "<y k='" + std::to_string(i) + "'>kept</y></x>\n";
+    }
+    big += "</r>";
+    auto expected = dumpFiltered(big);
+    CHECK(expected.find("skipped") == std::string::npos && expected.find("kept") != std::string::npos);
+    XmlParser f(0x10000);
+    f.addElementFilter("y");
+    CHECK(f.openFile(test::writeFile("filter.xml", big)) && test::dump(f) == expected);
+    std::string_view rest = big;
+    std::string s;
+    f.openStream();
+    for (;;)
+    {
+        if (f.next())
+        {
+            test::dumpItem(f, s);
+            continue;
+        }
+        if (!f.needsInput()) break;
+        auto piece = rest.substr(0, 7);
+        rest.remove_prefix(piece.size());
+        if (piece.empty()) f.finish();
+        else f.feed(piece.data(), piece.size());
+    }
+    CHECK(s + "error 0" == expected);
+    return test::result();
+}
@@ -0,0 +1,98 @@
+// The memory resource of XmlParser: with namespaces, entities, a filter and
+// batches, nothing is allocated from the default resource or the global heap;
+// nor is the read buffer.
+
+#include "test.h"
+#include "../xmltree.h"
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::size_t nHeapAllocations = 0;
+}
+
+void* operator new(std::size_t n)
+{
+    ++nHeapAllocations;
+    if (auto p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace
+{
+    /// Counts the allocations it passes on.
+    class CountingResource: public std::pmr::memory_resource
+    {
+        public:
+        CountingResource(std::pmr::memory_resource* upstream) noexcept: _upstream(upstream) {}
+        std::size_t count = 0;
+        private:
+        std::pmr::memory_resource* _upstream;
+        void* do_allocate(std::size_t n, std::size_t align) override
+        { ++count; return _upstream->allocate(n, align); }
+        void do_deallocate(void* p, std::size_t n, std::size_t align) override
+        { _upstream->deallocate(p, n, align); }
+        bool do_is_equal(const std::pmr::memory_resource& r) const noexcept override
+        { return this == &r; }
+    };
+}
+
+int main()
+{
+    std::string_view xml =
+        "<!DOCTYPE r [<!ENTITY e 'ent &f;'><!ENTITY f 'eff'>]>"
+        "<r xmlns='urn:a' xmlns:b='urn:b'><b:x k='v'>&e;</b:x><y a='1'>t</y><z/></r>";
+    static char buffer[0x100000];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+    CountingResource counter(&arena);
+
+    XmlParser p(XmlParser::default_chunk_size, &counter);
+    CHECK(p.getMemoryResource() == &counter);
+    p.setOptions(XmlParser::Options::kNamespaces | XmlParser::Options::kUnescapeText);
+    XmlParser::TokenBatch batch(&counter);
+    XmlTree tree(&counter);
+    std::size_t nItems = 0;
+    {
+        // allocating from the default resource throws, which terminates in noexcept code
+        auto old = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+        nHeapAllocations = 0;
+        p.addElementFilter("b:x");
+        p.addElementFilter("y");
+        p.openBuffer(xml.data(), xml.size());
+        while (p.nextBatch(batch, 2)) nItems += batch.size();
+        p.openBuffer(xml.data(), xml.size());
+        while (p.next() && !p.isElement("y")) {}
+        p.captureElement(tree);
+        CHECK(nHeapAllocations == 0);
+        std::pmr::set_default_resource(old);
+    }
+    CHECK(nItems == 10 && !p.error());
+    CHECK(batch.names.size() == 5);  // "" of the DTD, r, b:x, y, z
+    CHECK(tree.size() == 2 && tree.getRoot().getFirstChild().getText() == "t");
+    CHECK(counter.count != 0);
+
+    // the read buffer, unless backed by huge pages
+    auto before = counter.count;
+    {
+        FileReader r(0x10000, &counter);
+        CHECK(counter.count == before + 1 && r.capacity() == 0x10000);
+        CHECK(reinterpret_cast<std::uintptr_t>(r.data()) % FileReader::page_size == 0);
+        r.setPolicy(FileReader::Policy::kHugePages);
+        CHECK(!r.open("no such file.xml") && r.data() && counter.count == before + 1);
+    }
+
+    // std-typed and pmr attribute lists
+    p.openBuffer(xml.data(), xml.size());
+    while (p.next() && !p.isElement("b:x")) {}
+    std::vector<XmlParser::Attribute> attributes = p.getAttributes();
+    CHECK(attributes.size() == 1 && attributes[0].value == "v");
+    before = counter.count;
+    auto pmrAttributes = p.getAttributes(&counter);
+    CHECK(pmrAttributes.size() == 1 && counter.count == before + 1);
+    CHECK(p.next() && std::string(p.getText()) == "ent eff");
+    return test::result();
+}
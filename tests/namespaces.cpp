@@ -0,0 +1,73 @@
+// Options::kNamespaces: URIs of elements and attributes by the declarations in
+// scope, IDs stable across documents, and undeclared prefixes.
+
+#include "test.h"
+
+namespace
+{
+    /// "uri|local" of the current element.
+    std::string qname(const XmlParser& p)
+    {
+        return std::string(p.getNamespaceUri(p.getNamespaceId())) + '|' + std::string(p.getLocalName());
+    }
+}
+
+int main()
+{
+    std::string_view xml =
+        "<a:root xmlns:a='urn:a' xmlns=\"urn:d\">"
+          "<child b:x='1' y='2' xml:lang='en' xmlns:b='urn:b'>"
+            "<a:leaf xmlns:a='urn:other'/>"
+            "<inner xmlns=''>t</inner>"
+          "</child>"
+          "<a:leaf/>"
+        "</a:root>";
+    XmlParser p;
+    p.setOptions(XmlParser::Options::kNamespaces);
+    auto idA = p.internNamespace("urn:a");
+    CHECK(p.internNamespace("urn:a") == idA && p.getNamespaceUri(idA) == "urn:a");
+    CHECK(p.getNamespaceUri(0).empty() && p.getNamespaceUri(1000).empty());
+
+    std::string s;
+    p.openBuffer(xml.data(), xml.size());
+    while (p.next())
+    {
+        if (!p.isElement() && !p.isSuffix()) continue;
+        s += qname(p) + (p.isSuffix() ? " end\n" : "\n");
+        if (!p.isElement() || p.getName() != "child") continue;
+        for (auto& a : p.getAttributes())
+        {
+            auto id = p.getNamespaceId(a);
+            CHECK(id != XmlParser::unbound_namespace);
+            s.append("  @").append(p.getNamespaceUri(id)).append("|").append(a.name) += '\n';
+        }
+    }
+    CHECK(!p.error());
+    CHECK(s ==
+        "urn:a|root\n"
+        "urn:d|child\n"
+        "  @urn:b|b:x\n"
+        "  @|y\n"
+        "  @http://www.w3.org/XML/1998/namespace|xml:lang\n"
+        "  @http://www.w3.org/2000/xmlns/|xmlns:b\n"
+        "urn:other|leaf\n"
+        "|inner\n"
+        "|inner end\n"
+        "urn:d|child end\n"
+        "urn:a|leaf\n"
+        "urn:a|root end\n");
+
+    // the IDs stay, the declarations do not
+    std::string_view other = "<a:e xmlns:a='urn:a'/>";
+    p.openBuffer(other.data(), other.size());
+    CHECK(p.next() && p.getNamespaceId() == idA && p.getLocalName() == "e");
+    std::string_view undeclared = "<r><a:e/></r>";
+    p.openBuffer(undeclared.data(), undeclared.size());
+    CHECK(p.next() && !p.next() && p.getErrorCode() == XmlParser::ErrorCode::kErrNamespace);
+
+    // without the option, names are left as they are
+    XmlParser plain;
+    plain.openBuffer(undeclared.data(), undeclared.size());
+    CHECK(plain.next() && plain.next() && plain.getLocalName() == "a:e" && plain.getNamespaceId() == 0);
+    return test::result();
+}
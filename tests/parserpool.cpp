@@ -0,0 +1,71 @@
+// XmlParserPool and XmlBatchProcessor: parsers are reused with the settings
+// of the pool, and each document of a list is parsed once, errors counted.
+
+#include "test.h"
+#include "../parserpool.h"
+
+int main()
+{
+    XmlParserPool pool(0x10000);
+    pool.setOptions(XmlParser::Options::kTrimText);
+    pool.setSkipMask((int)XmlParser::ItemType::kComment);
+    pool.setReadPolicy(FileReader::Policy::kSequential);
+    XmlParser::Limits limits;
+    limits.maxDepth = 3;
+    pool.setLimits(limits);
+
+    XmlParser* first;
+    {
+        XmlParserPool::Lease p(pool);
+        CHECK(p && p->getOptions() == XmlParser::Options::kTrimText);
+        CHECK(p->getSkipMask() == (int)XmlParser::ItemType::kComment);
+        CHECK(p->getReadPolicy() == FileReader::Policy::kSequential && p->getLimits().maxDepth == 3);
+        first = &*p;
+        p->setOptions(0);
+        XmlParserPool::Lease q(pool);
+        CHECK(&*q != first && pool.size() == 2);
+    }
+    auto p = pool.acquire();
+    CHECK(pool.size() == 2 && p->getOptions() == XmlParser::Options::kTrimText);
+    pool.release(p);
+
+    std::vector<std::string> docs, paths;
+    for (int i = 0; i != 40; ++i)
+    {
+        auto k = std::to_string(i);
+        docs.push_back("<d n='" + k + "'> <!-- c --> " + k + " </d>");
+        paths.push_back("pool" + k + ".xml");
+        test::writeFile(paths.back().c_str(), docs.back());
+    }
+    docs[7] = "<a><b><c><d/></c></b></a>";  // too deep
+    test::writeFile(paths[7].c_str(), docs[7]);
+    paths[9] = "no such file.xml";
+
+    XmlBatchProcessor batch(pool, 3);
+    std::vector<std::string> texts(docs.size());
+    auto process = [&](std::size_t i, XmlParser& p)
+    {
+        while (p.next())
+        {
+            if (p.isText()) texts[i] += p.getText();
+        }
+    };
+    std::vector<std::string_view> buffers(docs.begin(), docs.end());
+    CHECK(!batch.processBuffers(buffers, process) && batch.getErrorCount() == 1);
+    for (std::size_t i = 0; i != docs.size(); ++i)
+    {
+        CHECK(texts[i] == (i == 7 ? "" : std::to_string(i)));
+    }
+
+    texts.assign(docs.size(), std::string());
+    CHECK(!batch.processFiles(paths, process) && batch.getErrorCount() == 2);
+    for (std::size_t i = 0; i != docs.size(); ++i)
+    {
+        CHECK(texts[i] == (i == 7 || i == 9 ? "" : std::to_string(i)));
+    }
+    CHECK(pool.size() <= 3);
+
+    paths.resize(5);
+    CHECK(batch.processFiles(paths, process) && batch.getErrorCount() == 0);
+    return test::result();
+}
@@ -0,0 +1,120 @@
+// Limits::maxTextChunk: long texts and CDATA come in pieces which are never
+// empty or over the limit, split no entity or UTF-8 sequence, and join into
+// the text of an unlimited parse, wherever the data given by feed() ends.
+
+#include "test.h"
+
+namespace
+{
+    const std::size_t limit = XmlParser::min_text_chunk;
+
+    void setLimit(XmlParser& p)
+    {
+        XmlParser::Limits limits;
+        limits.maxTextChunk = limit;
+        p.setLimits(limits);
+    }
+
+    /// Drops trailing blanks with Options::kTrimText: those of a block ending
+    /// with more blanks than the limit are not all held back (see isPartial()).
+    std::string& trimEnd(std::string& s, int options)
+    {
+        if (options & XmlParser::Options::kTrimText)
+        {
+            while (!s.empty() && s.back() == ' ') s.pop_back();
+        }
+        return s;
+    }
+
+    /// Texts and CDATA with their pieces joined, one per line; pieceSize 0
+    /// parses the whole document in memory without a limit.
+    std::string texts(std::string_view xml, int options, std::size_t pieceSize)
+    {
+        XmlParser p;
+        p.setOptions(options);
+        if (pieceSize)
+        {
+            setLimit(p);
+            p.openStream();
+        }
+        else p.openBuffer(xml.data(), xml.size());
+        std::string s;
+        bool partial = false;
+        for (;;)
+        {
+            if (p.next())
+            {
+                if (!p.isText() && p.getItemType() != XmlParser::ItemType::kCData) continue;
+                auto text = p.getText();
+                CHECK(p.isContinuation() == partial);
+                CHECK(text.size() <= limit || !pieceSize);
+                CHECK(!text.empty() || !p.isPartial());
+                CHECK(text.empty() || (text[0] & 0xC0) != 0x80);
+                if (!p.isContinuation()) trimEnd(s, options) += '\n';
+                s.append(text);
+                partial = p.isPartial();
+                continue;
+            }
+            if (!p.needsInput()) break;
+            auto piece = xml.substr(0, pieceSize);
+            xml.remove_prefix(piece.size());
+            if (piece.empty()) p.finish();
+            else p.feed(piece.data(), piece.size());
+        }
+        CHECK(!partial);
+        return trimEnd(s, options) + "\nerror " + std::to_string((int)p.getErrorCode());
+    }
+}
+
+int main()
+{
+    std::string x(limit, 'x'), y(limit - 3, 'y'), blanks(limit + 6, ' ');
+    const std::string blocks[] = {
+        x, x + x + 'x', y + "&amp;&lt;z", y + "\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80",
+        "<![CDATA[" + x + "]]>", "<![CDATA[" + y + "]]]]]>", "<![CDATA[" + x + x + "]]>",
+        y + "   \n  ", y + "   \n  z", "  " + x + blanks + "z", x + blanks + blanks,
+    };
+    const int options[] = {
+        0, XmlParser::Options::kUnescapeText, XmlParser::Options::kKeepCDATAtags,
+        XmlParser::Options::kTrimText, XmlParser::Options::kNormalizeSpace,
+        XmlParser::Options::kTrimText | XmlParser::Options::kUnescapeText,
+    };
+    for (auto& block : blocks)
+    {
+        auto xml = "<r>" + block + "<e/>" + block + "</r>";
+        for (auto o : options)
+        {
+            auto expected = texts(xml, o, 0);
+            for (std::size_t pieceSize : { std::size_t(1), std::size_t(5), limit, xml.size() })
+            {
+                CHECK(texts(xml, o, pieceSize) == expected);
+            }
+        }
+    }
+
+    // blank runs longer than a piece in the middle of a text, looked past
+    // again when the data ends there
+    std::string run(100, ' ');
+    auto spaced = "<r>" + x + 'c' + run + 'd' + std::string(70, 'b') + run + "e</r>";
+    for (int o : { XmlParser::Options::kTrimText, XmlParser::Options::kNormalizeSpace })
+    {
+        auto expected = texts(spaced, o, 0);
+        for (std::size_t pieceSize : { 1, 2, 3, 7, 13, 64 })
+        {
+            CHECK(texts(spaced, o, pieceSize) == expected);
+        }
+    }
+
+    // a checkpoint between the pieces of a text
+    std::string xml = "<r>" + x + x + x + "<e/></r>";
+    auto path = test::writeFile("pieces.xml", xml);
+    XmlParser p;
+    setLimit(p);
+    CHECK(p.openFile(path) && p.next() && p.next() && p.isPartial() && p.next() && p.isPartial());
+    auto state = p.saveState();
+    XmlParser q;
+    setLimit(q);
+    CHECK(q.restoreState(path, state) && q.isPartial());
+    CHECK(test::dump(q) == test::dump(p));
+    return test::result();
+}
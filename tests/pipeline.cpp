@@ -0,0 +1,70 @@
+// XmlRecordPipeline: records come back in source order whatever the number of
+// threads, with the namespaces and entities of the document in scope.
+
+#include "test.h"
+#include "../pipeline.h"
+
+namespace
+{
+    class Collector: public XmlRecordPipeline
+    {
+        public:
+
+        using XmlRecordPipeline::XmlRecordPipeline;
+        std::string output;
+
+        protected:
+
+        std::vector<std::string> _results;
+
+        void prepare(std::size_t nSlots) noexcept override { _results.resize(nSlots); }
+
+        void process(std::size_t slot, XmlParser& p) noexcept override
+        {
+            auto& s = _results[slot];
+            s.clear();
+            if (!p.next() || !p.isElement()) return;
+            s.append(p.getNamespaceUri(p.getNamespaceId())).append(" ").append(p.getLocalName());
+            while (p.next())
+            {
+                if (p.isText()) s.append(" ").append(p.getText());
+            }
+            s += p.error() ? " error\n" : "\n";
+        }
+
+        void emit(std::size_t slot) noexcept override { output += _results[slot]; }
+    };
+}
+
+int main()
+{
+    std::string xml = "<?xml version=\"1.0\"?><!DOCTYPE recs [<!ENTITY e \"entity\">]>\n"
+        "<recs xmlns:n='urn:n' xmlns='urn:default'>";
+    std::string expected;
+    for (int i = 0; i != 300; ++i)
+    {
+        auto k = std::to_string(i);
+        xml += "<n:r>&e; " + k + "<sub>s</sub></n:r><x/>";
+        expected += "urn:n r entity " + k + " s\n";
+    }
+    xml += "</recs>";
+    auto input = test::writeFile("pipeline.xml", xml);
+
+    for (std::size_t nThreads : { 1, 3 })
+    {
+        Collector c(nThreads, 0x10000);
+        c.setRecordName("n:r");
+        c.setWindow(5);
+        c.setOptions(XmlParser::Options::kNamespaces | XmlParser::Options::kUnescapeText);
+        CHECK(c.run(input) && c.getRecordCount() == 300);
+        CHECK(c.output == expected);
+    }
+
+    // any element at level 2, in the default namespace
+    Collector c(2);
+    c.setOptions(XmlParser::Options::kNamespaces);
+    CHECK(c.run(input) && c.getRecordCount() == 600);
+    CHECK(c.output.find("urn:default x\n") != std::string::npos);
+    CHECK(!c.run("no such file.xml"));
+    return test::result();
+}
@@ -0,0 +1,72 @@
+// FileReader::readAt(): the bytes at any position, aligned or not, with and
+// without kDirect, from several threads at once, leaving read() alone.
+
+#include "test.h"
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+int main()
+{
+    std::string data;
+    for (std::uint32_t x = 7; data.size() < 0x23456; )
+    {
+        x = x * 1103515245 + 12345;
+        data += char(x >> 24);
+    }
+    auto path = test::writeFile("readat.bin", data);
+
+    for (int policy : { FileReader::Policy::kDefault, FileReader::Policy::kDirect })
+    {
+        FileReader r(0x10000);
+        r.setPolicy(policy);
+        CHECK(r.open(path));
+        auto n = r.read();
+        CHECK(n == r.capacity());
+
+        std::string buf(0x3000, 0);
+        for (std::uint64_t pos : { 0, 1, 0x1000, 0xfff, 0x10001, 0x23456 - 0x3000 })
+        {
+            for (std::size_t size : { 1, 0x1000, 0x1001, 0x3000 })
+            {
+                CHECK(r.readAt(pos, buf.data(), size) == size && data.compare(pos, size, buf.data(), size) == 0);
+            }
+        }
+        // at and past the end
+        CHECK(r.readAt(0x23456 - 10, buf.data(), 0x3000) == 10 && data.compare(0x23456 - 10, 10, buf.data(), 10) == 0);
+        CHECK(r.readAt(0x23456, buf.data(), 0x3000) == 0 && r.readAt(0x100000, buf.data(), 1) == 0);
+
+        // aligned, as with kDirect
+        std::vector<char> space(0x2000 + FileReader::direct_align);
+        auto aligned = space.data() + (-reinterpret_cast<std::uintptr_t>(space.data()) & (FileReader::direct_align - 1));
+        CHECK(r.readAt(0x2000, aligned, 0x2000) == 0x2000 && data.compare(0x2000, 0x2000, aligned, 0x2000) == 0);
+
+        std::vector<std::thread> threads;
+        std::vector<int> ok(4);
+        for (std::size_t i = 0; i != ok.size(); ++i)
+        {
+            threads.emplace_back([&, i]()
+            {
+                std::string part(0x777, 0);
+                ok[i] = 1;
+                for (std::uint64_t pos = i * 0x111; pos + part.size() <= data.size(); pos += 0x3001)
+                {
+                    if (r.readAt(pos, part.data(), part.size()) != part.size() ||
+                        data.compare(pos, part.size(), part) != 0) ok[i] = 0;
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+        CHECK(ok == std::vector<int>(4, 1));
+
+        // read() goes on where it was
+        std::string rest;
+        for (std::size_t k; (k = r.read()); ) rest.append(r.data(), k);
+        CHECK(rest == data.substr(n) && !r.error());
+    }
+
+    FileReader closed(0x1000);
+    char c;
+    CHECK(closed.readAt(0, &c, 1) == 0);
+    return test::result();
+}
@@ -0,0 +1,67 @@
+// XmlSaxHandler: the callbacks see the items of next(), and items without a
+// callback are skipped for the time of parse().
+
+#include "test.h"
+#include "../sax.h"
+
+namespace
+{
+    struct Recorder : XmlSaxHandler<Recorder>
+    {
+        std::string s;
+        void add(const char* what, const XmlParser& p)
+        {
+            s.append(what).append(" ").append(p.getName()).append(": ").append(p.getText()) += '\n';
+        }
+        void onStart(const XmlParser& p) noexcept { add("start", p); }
+        void onEnd(const XmlParser& p) noexcept { add("end", p); }
+        void onText(const XmlParser& p) noexcept { add("text", p); }
+        void onCData(const XmlParser& p) noexcept { add("cdata", p); }
+        void onPI(const XmlParser& p) noexcept { add("pi", p); }
+        void onComment(const XmlParser& p) noexcept { add("comment", p); }
+        void onDTD(const XmlParser& p) noexcept { add("dtd", p); }
+    };
+
+    struct Counter : XmlSaxHandler<Counter>
+    {
+        std::size_t nStart = 0, nEnd = 0;
+        std::string starts;
+        void onStart(const XmlParser& p) noexcept
+        {
+            ++nStart;
+            starts.append(p.getName()) += char('0' + p.getLevel());
+        }
+        void onEnd(const XmlParser&) noexcept { ++nEnd; }
+    };
+}
+
+int main()
+{
+    std::string_view xml =
+        "<?pi x?><!DOCTYPE a><a>t<!--c--><b><c/></b><![CDATA[d]]></a>";
+    XmlParser p;
+    Recorder r;
+    CHECK(p.openBuffer(xml.data(), xml.size()) && r.parse(p));
+    CHECK(r.s ==
+        "pi : <?pi x?>\n"
+        "dtd : <!DOCTYPE a>\n"
+        "start a: <a>\n"
+        "text a: t\n"
+        "comment a: <!--c-->\n"
+        "start b: <b>\n"
+        "start c: <c/>\n"
+        "end c: <c/>\n"
+        "end b: </b>\n"
+        "cdata a: <![CDATA[d]]>\n"
+        "end a: </a>\n");
+
+    Counter c;
+    p.setSkipMask((int)XmlParser::ItemType::kPI);
+    CHECK(p.openBuffer(xml.data(), xml.size()) && c.parse(p));
+    CHECK(c.nStart == 3 && c.nEnd == 3 && c.starts == "a1b2c3");
+    CHECK(p.getSkipMask() == (int)XmlParser::ItemType::kPI);
+
+    std::string_view bad = "<a><b></a>";
+    CHECK(p.openBuffer(bad.data(), bad.size()) && !c.parse(p) && p.error());
+    return test::result();
+}
@@ -0,0 +1,77 @@
+// setSkipMask(): for any mask, the items are those of a full parse without
+// the masked types, from a file of several chunks and from a stream.
+
+#include "test.h"
+#include <sstream>
+
+namespace
+{
+    /// Lines of a dump without the items of the types of a mask.
+    std::string withoutTypes(const std::string& dump, int mask)
+    {
+        std::istringstream in(dump);
+        std::string s;
+        for (std::string line; std::getline(in, line); )
+        {
+            if (line.compare(0, 6, "error ") != 0 && (std::stoi(line) & mask)) continue;
+            s.append(line) += '\n';
+        }
+        s.pop_back();
+        return s;
+    }
+
+    std::string dumpFed(std::string_view xml, int mask, std::size_t pieceSize)
+    {
+        XmlParser p;
+        p.setSkipMask(mask);
+        p.openStream();
+        std::string s;
+        for (;;)
+        {
+            if (p.next())
+            {
+                test::dumpItem(p, s);
+                continue;
+            }
+            if (!p.needsInput()) break;
+            auto piece = xml.substr(0, pieceSize);
+            xml.remove_prefix(piece.size());
+            if (piece.empty()) p.finish();
+            else p.feed(piece.data(), piece.size());
+        }
+        return s + "error " + std::to_string((int)p.getErrorCode());
+    }
+}
+
+int main()
+{
+    using T = XmlParser::ItemType;
+    std::string xml = "<?xml version=\"1.0\"?><!DOCTYPE r [<!ENTITY e \"<>\">]><r>";
+    for (int i = 0; i != 2000; ++i)
+    {
+        xml += "<i>text " + std::to_string(i) + "<!-- <i>no</i> --><?pi <i>?><![CDATA[<i>]]></i>\n";
+    }
+    xml += "<!--" + std::string(0x30000, '-') + " --></r>";
+    auto path = test::writeFile("skipmask.xml", xml);
+    auto full = test::dump(xml);
+
+    const int types[] = { (int)T::kEscapedText, (int)T::kCData, (int)T::kPI, (int)T::kComment, (int)T::kDTD };
+    for (int bits = 0; bits != 1 << 5; ++bits)
+    {
+        int mask = 0;
+        for (int k = 0; k != 5; ++k) if (bits & (1 << k)) mask |= types[k];
+        auto expected = withoutTypes(full, mask);
+        XmlParser p(0x10000);
+        p.setSkipMask(mask | (int)T::kPrefix);
+        CHECK(p.getSkipMask() == mask);
+        CHECK(p.openFile(path) && test::dump(p) == expected);
+        auto head = std::string_view(xml).substr(0, 3000);
+        CHECK(dumpFed(head, mask, 5) == withoutTypes(dumpFed(head, 0, head.size()), mask));
+    }
+
+    // elements cannot be skipped
+    XmlParser p;
+    p.setSkipMask((int)T::kPrefix | (int)T::kSuffix | (int)T::kSelfClosing);
+    CHECK(p.getSkipMask() == 0);
+    return test::result();
+}
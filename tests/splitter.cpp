@@ -0,0 +1,92 @@
+// XmlSplitter: shards are documents with the prolog and the root, holding the
+// records round-robin or by key.
+
+#include "test.h"
+#include "../splitter.h"
+
+namespace
+{
+    /// The records of a shard, checking that it parses with the prolog and root.
+    std::string records(const char* path)
+    {
+        XmlParser p;
+        std::string s;
+        CHECK(p.openFile(path) && p.next() && p.isPI() && p.next() && p.isComment());
+        CHECK(p.next() && p.isElement("recs") && p.getAttributes().size() == 1);
+        while (p.next() && p.getLevel() >= 2)
+        {
+            if (!p.isElement() || p.getLevel() != 2) continue;
+            s.append(p.hasAttributes() ? p.getAttributes()[0].value : "-");
+        }
+        CHECK(p.isSuffix() && p.getName() == "recs" && !p.next() && !p.error());
+        return s;
+    }
+}
+
+int main()
+{
+    auto input = test::writeFile("splitter.xml",
+        "<?xml version=\"1.0\"?>\n"
+        "<!-- prolog -->\n"
+        "<recs a='1'>\n"
+        "  <r k='x'>1</r>\n"
+        "  <other/>\n"
+        "  <r k='y'><s/>2</r>\n"
+        "  <r k='x'>3</r>\n"
+        "  <r k='z'/>\n"
+        "</recs>\n");
+    const std::vector<std::string> shards = { "shard0.xml", "shard1.xml", "shard2.xml" };
+
+    XmlSplitter s;
+    s.setRecordName("r");
+    s.setThreadCount(2);
+    CHECK(s.split(input, shards));
+    CHECK(s.getRecordCount() == 4);
+    CHECK(records("shard0.xml") == "xz" && records("shard1.xml") == "y" && records("shard2.xml") == "x");
+
+    // by key, records of one key go to one shard
+    s.setKeyAttribute("k");
+    CHECK(s.split(input, shards));
+    std::string all;
+    for (auto& shard : shards)
+    {
+        auto keys = records(shard.c_str());
+        CHECK(keys.empty() || keys.find_first_not_of(keys[0]) == std::string::npos);
+        all += keys;
+    }
+    std::sort(all.begin(), all.end());
+    CHECK(all == "xxyz");
+
+    // without a name, <other/> is a record too
+    s.setRecordName("");
+    s.setKeyAttribute("");
+    CHECK(s.split(input, shards) && s.getRecordCount() == 5);
+    CHECK(records("shard0.xml") == "xx" && records("shard1.xml") == "-z" && records("shard2.xml") == "y");
+
+    // records at level 3 keep the namespaces declared around them
+    auto nested = test::writeFile("splitter-ns.xml",
+        "<recs xmlns='urn:r'>"
+        "<g xmlns:a='urn:a' xmlns:b=\"urn:'b'\"><h xmlns:a='urn:a2'>"
+        "<a:r/><b:r xmlns:b='urn:b2'>t</b:r><a:r><b:x/></a:r>"
+        "</h></g></recs>");
+    s.setRecordLevel(4);
+    s.setRecordName("");
+    CHECK(s.split(nested, shards) && s.getRecordCount() == 3);
+    std::string uris;
+    for (auto& shard : shards)
+    {
+        XmlParser p;
+        p.setOptions(XmlParser::Options::kNamespaces);
+        CHECK(p.openFile(shard.c_str()));
+        while (p.next())
+        {
+            if (p.isPrefix() || p.isSelfClosing()) uris.append(p.getNamespaceUri(p.getNamespaceId())) += ' ';
+        }
+        CHECK(!p.error());
+    }
+    CHECK(uris == "urn:r urn:a2 urn:r urn:b2 urn:r urn:a2 urn:'b' ");
+
+    s.setRecordLevel(1);
+    CHECK(!s.split(input, shards));
+    return test::result();
+}
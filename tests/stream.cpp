@@ -0,0 +1,144 @@
+// Stream mode, items() and AsyncItemStream: the items of data given piece by
+// piece are those of the whole document.
+
+#include "test.h"
+#include "../async.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    std::string dumpFed(std::string_view xml, std::size_t pieceSize)
+    {
+        XmlParser p;
+        p.openStream();
+        std::string s;
+        for (;;)
+        {
+            if (p.next())
+            {
+                test::dumpItem(p, s);
+                continue;
+            }
+            if (!p.needsInput()) break;
+            auto piece = xml.substr(0, pieceSize);
+            xml.remove_prefix(piece.size());
+            if (piece.empty()) p.finish();
+            else p.feed(piece.data(), piece.size());
+        }
+        return s + "error " + std::to_string((int)p.getErrorCode());
+    }
+
+#ifdef __cpp_impl_coroutine
+    /// Source whose reads complete when the test says so, a few bytes each.
+    struct ManualSource
+    {
+        std::string_view data;
+        std::coroutine_handle<> waiting;
+
+        auto read(char* dst, std::size_t n) noexcept
+        {
+            struct awaiter
+            {
+                ManualSource& source;
+                char* dst;
+                std::size_t n;
+                bool await_ready() noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> h) noexcept { source.waiting = h; }
+                std::size_t await_resume() noexcept
+                {
+                    auto piece = source.data.substr(0, std::min<std::size_t>(n, 5));
+                    memcpy(dst, piece.data(), piece.size());
+                    source.data.remove_prefix(piece.size());
+                    return piece.size();
+                }
+            };
+            return awaiter{ *this, dst, n };
+        }
+
+        bool complete() noexcept
+        {
+            if (!waiting) return false;
+            std::exchange(waiting, {}).resume();
+            return true;
+        }
+    };
+
+    XmlTask<std::string> dumpAsync(ManualSource& source)
+    {
+        XmlParser p;
+        AsyncItemStream<ManualSource> items(p, source, 16);
+        std::string s;
+        while (co_await items.next()) test::dumpItem(p, s);
+        co_return s + "error " + std::to_string((int)p.getErrorCode());
+    }
+#endif
+}
+
+int main()
+{
+    std::string_view xml =
+        "<?xml version=\"1.0\"?><!DOCTYPE r><r a='1'>text &amp; more<!-- c -->"
+        "<e x=\"y\"/><![CDATA[ <cdata> ]]><?pi data?></r>";
+    auto expected = test::dump(xml);
+    for (std::size_t pieceSize : { 1, 2, 3, 7, 64, 1000 })
+    {
+        CHECK(dumpFed(xml, pieceSize) == expected);
+    }
+    // data ending inside a tag, the same as a buffer ending there
+    for (std::size_t size : { 30, 50 })
+    {
+        CHECK(dumpFed(xml.substr(0, size), 4) == test::dump(xml.substr(0, size)));
+    }
+
+    // copyElement() is not available: nothing is written, the parse goes on
+    {
+        struct Sink: XmlParser::IWriter
+        {
+            std::size_t n = 0;
+            void write(const char*, std::size_t size, std::size_t) override { n += size; }
+        } sink;
+        XmlParser p;
+        p.openStream();
+        p.feed(xml.data(), xml.size());
+        p.finish();
+        while (p.next() && !p.isElement()) {}
+        CHECK(p.isElement("r") && !p.copyElement(sink, 0) && sink.n == 0);
+        CHECK(p.isElement("r") && p.next() && p.isText() && !p.error());
+    }
+
+    XmlParser p;
+    p.openBuffer(xml.data(), xml.size());
+    std::string s;
+    for (auto item : p.items())
+    {
+        s += std::to_string((int)item.type) + ' ' + std::to_string(item.level) + ' ';
+        s.append(item.name).append(": ").append(item.text) += '\n';
+    }
+    CHECK(s + "error 0" == expected);
+    p.openBuffer(xml.data(), xml.size());
+    auto nElements = std::ranges::count_if(p.items(),
+        [](const XmlParser::ItemView& v) { return v.type == XmlParser::ItemType::kPrefix; });
+    CHECK(nElements == 1);
+
+#ifdef __cpp_impl_coroutine
+    ManualSource source{ xml, {} };
+    auto task = dumpAsync(source);
+    task.resume();
+    std::size_t nReads = 0;
+    while (!task.done() && source.complete()) ++nReads;
+    CHECK(task.done() && task.result() == expected);
+    CHECK(nReads > xml.size() / 5);
+
+    // items in the data read come without suspending; texts have a limit
+    XmlParser q;
+    ManualSource none{ {}, {} };
+    AsyncItemStream<ManualSource> items(q, none, 0x1000);
+    CHECK(q.getLimits().maxTextChunk == 0x1000);
+    CHECK(!items.next().await_ready());
+    q.feed(xml.data(), xml.size());
+    auto next = items.next();
+    CHECK(next.await_ready() && next.await_resume() && q.getItemType() == XmlParser::ItemType::kPI);
+#endif
+    return test::result();
+}
@@ -0,0 +1,80 @@
+// StructuralIndex and Options::kStructuralIndex: the masks and positions of
+// braces, and items the same as those of the plain scan.
+
+#include "test.h"
+
+namespace
+{
+    std::string dumpStream(std::string_view xml, int options, std::size_t pieceSize)
+    {
+        XmlParser p;
+        p.setOptions(options);
+        p.openStream();
+        std::string s;
+        for (;;)
+        {
+            if (p.next())
+            {
+                test::dumpItem(p, s);
+                continue;
+            }
+            if (!p.needsInput()) break;
+            auto piece = xml.substr(0, pieceSize);
+            xml.remove_prefix(piece.size());
+            if (piece.empty()) p.finish();
+            else p.feed(piece.data(), piece.size());
+        }
+        return s + "error " + std::to_string((int)p.getErrorCode());
+    }
+}
+
+int main()
+{
+    std::string block = "<a b='>'>x</a>";
+    block.resize(StructuralIndex::block_size, ' ');
+    block[63] = '<';
+    auto m = StructuralIndex::classify(block.data());
+    CHECK(m.lt == ((1ull << 0) | (1ull << 10) | (1ull << 63)));
+    CHECK(m.gt == ((1ull << 6) | (1ull << 8) | (1ull << 13)));
+    m = StructuralIndex::classify(block.data(), 10);  // the rest is blank
+    CHECK(m.lt == 1 && m.gt == ((1ull << 6) | (1ull << 8)));
+
+    std::string data(200, 'x');
+    data[3] = '<';
+    data[70] = '>';
+    data[150] = '<';
+    StructuralIndex index;
+    index.build(data.data(), data.size());
+    auto b = data.data(), e = b + data.size();
+    CHECK(index.isBuilt(b, e) && !index.isBuilt(b, e - 1) && index.end() == e);
+    CHECK(index.find(b, 0) == b + 3 && index.find(b + 4, 0) == b + 70);
+    CHECK(index.find(b + 4, '<') == b + 150 && index.find(b + 151, 0) == e);
+    CHECK(index.find(b, '>') == b + 70);  // moved back
+    index.clear();
+    CHECK(!index.isBuilt(b, e));
+
+    // items across chunk and piece boundaries, with braces in values, comments and CDATA
+    std::string xml = "<?xml version=\"1.0\"?><root>";
+    for (int i = 0; i != 5000; ++i)
+    {
+        xml += "<item n='" + std::to_string(i) + "' cmp=\"a>b\">t&lt;" + std::to_string(i) +
+            "<!-- <no> --><![CDATA[<raw>]]><e/></item>\n";
+    }
+    xml += "</root>";
+    auto path = test::writeFile("structural.xml", xml);
+    const int indexed = XmlParser::Options::kStructuralIndex;
+    XmlParser plain(0x10000), fast(0x10000);  // the smallest buffer, of several chunks
+    CHECK(xml.size() > 0x40000);
+    fast.setOptions(indexed);
+    CHECK(plain.openFile(path) && fast.openFile(path));
+    auto expected = test::dump(plain);
+    CHECK(expected.size() > xml.size() && test::dump(fast) == expected);
+    CHECK(test::dump(xml, indexed) == expected);
+    auto head = std::string_view(xml).substr(0, 20000);
+    expected = dumpStream(head, 0, head.size());
+    for (std::size_t pieceSize : { 1, 63, 64, 65, 4096 })
+    {
+        CHECK(dumpStream(head, indexed, pieceSize) == expected);
+    }
+    return test::result();
+}
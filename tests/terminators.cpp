@@ -0,0 +1,93 @@
+// Comment, CDATA and PI terminators: simd::find_string() as string_view::find(),
+// and items ending right, wherever the chunks or pieces of the input end.
+
+#include "test.h"
+#include "../simd.h"
+
+namespace
+{
+    std::string dumpFed(std::string_view xml, std::size_t pieceSize)
+    {
+        XmlParser p;
+        p.openStream();
+        std::string s;
+        for (;;)
+        {
+            if (p.next())
+            {
+                test::dumpItem(p, s);
+                continue;
+            }
+            if (!p.needsInput()) break;
+            auto piece = xml.substr(0, pieceSize);
+            xml.remove_prefix(piece.size());
+            if (piece.empty()) p.finish();
+            else p.feed(piece.data(), piece.size());
+        }
+        return s + "error " + std::to_string((int)p.getErrorCode());
+    }
+}
+
+int main()
+{
+    using char_parsers::simd::find_string;
+    std::string data;
+    for (std::uint32_t x = 3; data.size() != 200; )
+    {
+        x = x * 1103515245 + 12345;
+        data += "-]>?ab"[(x >> 16) % 6];
+    }
+    for (std::string_view s : { "-->", "]]>", "?>", ">", "", "--->", "ab-]>?" })
+    {
+        for (std::size_t begin = 0; begin != 20; ++begin)
+        {
+            for (std::size_t end = begin; end <= data.size(); end += 7)
+            {
+                std::string_view range(data.data() + begin, end - begin);
+                auto i = range.find(s);
+                auto f = find_string(range.data(), range.data() + range.size(), s.data(), s.size());
+                CHECK(f == (i == std::string_view::npos ? range.data() + range.size() : range.data() + i));
+            }
+        }
+    }
+
+    std::string_view items =
+        "<r><!-- a -> b --><!----><!-- - -- --->"
+        "<![CDATA[]]><![CDATA[x]]]]><![CDATA[ ]] ]> ]]>"
+        "<?pi ? > ?><?pi?" "?>"
+        "<!-- <![CDATA[ --><![CDATA[ <!-- ]]><?pi --> ?></r>";
+    auto expected = test::dump(items);
+    CHECK(expected ==
+        "1 1 r: <r>\n"
+        "64 1 r: <!-- a -> b -->\n"
+        "64 1 r: <!---->\n"
+        "64 1 r: <!-- - -- --->\n"
+        "16 1 r: <![CDATA[]]>\n"
+        "16 1 r: <![CDATA[x]]]]>\n"
+        "16 1 r: <![CDATA[ ]] ]> ]]>\n"
+        "32 1 r: <?pi ? > ?>\n"
+        "32 1 r: <?pi?" "?>\n"
+        "64 1 r: <!-- <![CDATA[ -->\n"
+        "16 1 r: <![CDATA[ <!-- ]]>\n"
+        "32 1 r: <?pi --> ?>\n"
+        "2 1 r: </r>\n"
+        "error 0");
+    for (std::size_t pieceSize = 1; pieceSize != 8; ++pieceSize)
+    {
+        CHECK(dumpFed(items, pieceSize) == expected);
+    }
+
+    // terminators around the end of each chunk of a file
+    std::string xml = "<r>";
+    for (std::size_t i = 0; xml.size() < 0x50000; ++i)
+    {
+        auto fill = std::string(i % 37, i % 2 ? '-' : ']');
+        xml += "<!--" + fill + "-->\n<![CDATA[" + fill + "]]>\n<?p " + fill + "?>\n";
+    }
+    xml += "</r>";
+    expected = test::dump(xml);
+    XmlParser p(0x10000);
+    CHECK(expected.ends_with("</r>\nerror 0"));
+    CHECK(p.openFile(test::writeFile("terminators.xml", xml)) && test::dump(p) == expected);
+    return test::result();
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+// Helpers of the tests: each test is a program which CHECKs its cases and
+// returns test::result(); files are written to the working directory.
+
+#include "../processor.h"
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#define CHECK(e) ((e) ? (void)0 : test::fail(#e, __FILE__, __LINE__))
+
+namespace test
+{
+    inline int failures = 0;
+
+    inline void fail(const char* e, const char* file, int line)
+    {
+        std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, e);
+        ++failures;
+    }
+
+    /// Exit code of the test.
+    inline int result()
+    {
+        if (failures) std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return failures ? 1 : 0;
+    }
+
+    /// Writes a file; returns its name.
+    inline const char* writeFile(const char* name, std::string_view data)
+    {
+        auto f = std::fopen(name, "wb");
+        if (!f) return name;
+        std::fwrite(data.data(), 1, data.size(), f);
+        std::fclose(f);
+        return name;
+    }
+
+    /// Reads a file; empty if it does not exist.
+    inline std::string readFile(const char* name)
+    {
+        std::string s;
+        auto f = std::fopen(name, "rb");
+        if (!f) return s;
+        char buf[0x1000];
+        for (std::size_t n; (n = std::fread(buf, 1, sizeof(buf), f)); ) s.append(buf, n);
+        std::fclose(f);
+        return s;
+    }
+
+    /// Appends an item as "type level name: text" and a line feed.
+    inline void dumpItem(const XmlParser& p, std::string& dst)
+    {
+        dst += std::to_string((int)p.getItemType()) + ' ' + std::to_string(p.getLevel()) + ' ';
+        dst.append(p.getName()).append(": ").append(p.getText()) += '\n';
+    }
+
+    /// Dumps the items left up to the end and the error code.
+    inline std::string dump(XmlParser& p)
+    {
+        std::string s;
+        while (p.next()) dumpItem(p, s);
+        return s + "error " + std::to_string((int)p.getErrorCode());
+    }
+
+    /// Dumps the items of a document in memory, parsed with the options given.
+    inline std::string dump(std::string_view xml, int options = 0)
+    {
+        XmlParser p;
+        p.setOptions(options);
+        p.openBuffer(xml.data(), xml.size());
+        return dump(p);
+    }
+}
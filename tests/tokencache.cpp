@@ -0,0 +1,119 @@
+// Options::kTokenCache: a cache is written by a full parse, replayed by the
+// next ones with the same items, and not used when the source or the
+// settings change.
+
+#include "test.h"
+#include <filesystem>
+
+namespace
+{
+    const char* cachePath = "tokencache.xml.xtc";
+
+    /// Dumps the file and tells whether the items were replayed.
+    std::string dumpFile(const char* path, int options, bool& replayed, std::size_t maxTextChunk = 0)
+    {
+        XmlParser p;
+        XmlParser::Limits limits;
+        limits.maxTextChunk = maxTextChunk;
+        p.setLimits(limits);
+        p.setOptions(options | XmlParser::Options::kTokenCache);
+        if (!p.openFile(path)) return "not opened";
+        replayed = p.next() && p.saveState().empty();  // no checkpoints while replaying
+        std::string s;
+        test::dumpItem(p, s);
+        return s + test::dump(p);
+    }
+}
+
+int main()
+{
+    std::string xml = "<?xml version=\"1.0\"?><!DOCTYPE r [<!ENTITY e \"ent\">]><r xmlns:p='urn:p'>\n";
+    for (int i = 0; i != 300; ++i)
+    {
+        xml += "  <p:i a='" + std::to_string(i) + "'>text &e; " + std::string(i % 150, 'x') +
+            "<!-- c --><![CDATA[<d>]]><e/></p:i>\n";
+    }
+    xml += "</r>";
+    auto path = test::writeFile("tokencache.xml", xml);
+    std::filesystem::remove(cachePath);
+    const int options = XmlParser::Options::kUnescapeText | XmlParser::Options::kNamespaces;
+    std::string expected;
+    {
+        XmlParser p;
+        p.setOptions(options);
+        p.openFile(path);
+        expected = test::dump(p);
+    }
+
+    bool replayed = true;
+    CHECK(dumpFile(path, options, replayed) == expected && !replayed);
+    CHECK(std::filesystem::exists(cachePath));
+    CHECK(dumpFile(path, options, replayed) == expected && replayed);
+    CHECK(dumpFile(path, options, replayed) == expected && replayed);
+
+    // other settings make another cache
+    auto trimmed = dumpFile(path, options | XmlParser::Options::kTrimText, replayed);
+    CHECK(!replayed && dumpFile(path, options | XmlParser::Options::kTrimText, replayed) == trimmed && replayed);
+    CHECK(dumpFile(path, options, replayed) == expected && !replayed);
+    auto pieces = dumpFile(path, options, replayed, 64);
+    CHECK(!replayed && pieces != expected && dumpFile(path, options, replayed, 64) == pieces && replayed);
+
+    // a skip mask or an early close writes none
+    std::filesystem::remove(cachePath);
+    {
+        XmlParser p;
+        p.setOptions(options | XmlParser::Options::kTokenCache);
+        p.setSkipMask((int)XmlParser::ItemType::kComment);
+        CHECK(p.openFile(path));
+        test::dump(p);
+        CHECK(p.openFile(path) && p.next() && p.next());
+        p.closeFile();
+    }
+    CHECK(!std::filesystem::exists(cachePath));
+
+    // a changed source
+    CHECK(dumpFile(path, options, replayed) == expected && !replayed);
+    xml.insert(xml.size() - 4, "<new/>");
+    test::writeFile(path, xml);
+    {
+        XmlParser p;
+        p.setOptions(options);
+        p.openFile(path);
+        expected = test::dump(p);
+    }
+    CHECK(dumpFile(path, options, replayed) == expected && !replayed);
+    CHECK(dumpFile(path, options, replayed) == expected && replayed);
+
+    // a truncated cache is a read error, not fewer items
+    std::filesystem::resize_file(cachePath, std::filesystem::file_size(cachePath) / 2);
+    auto truncated = dumpFile(path, options, replayed);
+    CHECK(truncated.ends_with("error " + std::to_string((int)XmlParser::ErrorCode::kErrReadFile)));
+
+    // the file format on its own
+    TokenCache::Key key;
+    CHECK(TokenCache::getSourceKey(path, key) && key.size == xml.size());
+    TokenCache cache;
+    CHECK(cache.openWrite(path, key) && cache.isWriting());
+    TokenCache::Item item;
+    item.type = (int)XmlParser::ItemType::kEscapedText;
+    item.partial = true;
+    item.pos = 1000;
+    item.end = 1010;
+    item.text = "some text";
+    cache.write(item);
+    item.partial = false;
+    item.continued = true;
+    item.pos = item.end = 1010;
+    item.text = "";
+    cache.write(item);
+    CHECK(cache.commit() && !cache.isWriting());
+    CHECK(cache.openRead(path, key) && cache.isReading());
+    TokenCache::Item r;
+    CHECK(cache.read(r) && r.type == item.type && r.partial && !r.continued && r.pos == 1000 && r.end == 1010 && r.text == "some text");
+    CHECK(cache.read(r) && !r.partial && r.continued && r.pos == 1010 && r.end == 1010 && r.text.empty());
+    CHECK(!cache.read(r) && !cache.error());
+    auto other = key;
+    other.options = 1;
+    CHECK(!cache.openRead(path, other));
+    return test::result();
+}
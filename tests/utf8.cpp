@@ -0,0 +1,82 @@
+// u8charser and the UTF-8 scanners: counting, skipping, slicing and decoding
+// as a plain decoder does, at any alignment, stray continuation bytes included.
+
+#include "test.h"
+#include "../charser.h"
+#include <vector>
+
+namespace
+{
+    using namespace char_parsers;
+
+    /// Plain decoder of valid UTF-8.
+    std::u32string decodeAll(std::string_view s)
+    {
+        std::u32string r;
+        for (std::size_t i = 0; i != s.size(); )
+        {
+            auto c = static_cast<unsigned char>(s[i]);
+            std::size_t n = c < 0x80 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+            char32_t v = n == 1 ? c : c & (0x7F >> n);
+            for (std::size_t k = 1; k != n; ++k) v = (v << 6) | (s[i + k] & 0x3F);
+            r += v;
+            i += n;
+        }
+        return r;
+    }
+}
+
+int main()
+{
+    std::string text;
+    const char* parts[] = { "plain ascii run of more than sixteen bytes", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "x" };
+    for (int i = 0; i != 60; ++i) text += parts[(i * 7) % 5];
+    auto chars = decodeAll(text);
+
+    // starts at each character within the first 40
+    std::vector<std::size_t> starts;
+    for (std::size_t i = 0; i != text.size() && starts.size() != 40; ++i)
+    {
+        if ((text[i] & 0xC0) != 0x80) starts.push_back(i);
+    }
+    for (std::size_t k = 0; k != starts.size(); ++k)
+    {
+        std::string_view s = std::string_view(text).substr(starts[k]);
+        auto expected = chars.substr(k);
+        const char* e = s.data() + s.size();
+        CHECK(simd::count_utf8(s.data(), e) == expected.size());
+        u8charser it(s.data(), e);
+        CHECK(it.length() == expected.size());
+
+        for (std::size_t n : { 0, 1, 5, 17, 100, 100000 })
+        {
+            std::u32string decoded(n, U'\0');
+            u8charser d(s.data(), e);
+            decoded.resize(d.decode(decoded.data(), n));
+            CHECK(decoded == expected.substr(0, n));
+            auto head = u8charser(s.data(), e).head(n);
+            CHECK(head.data() == s.data() && head.size() == std::size_t(d.get() - s.data()));
+
+            u8charser sk(s.data(), e);
+            CHECK(sk.skip(n) == (n <= expected.size()) && sk.get() == d.get());
+        }
+
+        auto a = simd::find_non_ascii(s.data(), e);
+        auto plain = s.data();
+        while (plain != e && static_cast<unsigned char>(*plain) < 0x80) ++plain;
+        CHECK(a == plain);
+        std::u32string wide(s.size(), U'\0');
+        CHECK(simd::widen_ascii(s.data(), e, wide.data()) == std::size_t(a - s.data()));
+        CHECK(wide.substr(0, a - s.data()) == expected.substr(0, a - s.data()));
+    }
+
+    // stray continuation bytes are not characters
+    std::string_view stray = "a\x80\x80" "b\xC3\xA9\xBF" "c";
+    u8charser it(stray.data(), stray.data() + stray.size());
+    CHECK(it.length() == 4);
+    char32_t out[8];
+    CHECK(it.decode(out, 8) == 4 && out[0] == U'a' && out[1] == U'b' && out[2] == U'\u00E9' && out[3] == U'c');
+    u8charser sk(stray.data(), stray.data() + stray.size());
+    CHECK(sk.skip(2) && sk.getc() == U'\u00E9' && sk.getc() == U'c' && !sk.skip());
+    return test::result();
+}
@@ -0,0 +1,68 @@
+// char_parsers::parse_xxx() and the typed getters of texts and attributes:
+// whole spans only, blanks trimmed on request, values kept on failure.
+
+#include "test.h"
+#include <cmath>
+
+namespace
+{
+    using namespace char_parsers;
+    using namespace std::chrono;
+
+    std::int64_t micros(std::string_view s)
+    {
+        timestamp t{};
+        return parse_timestamp(s, t) ? t.time_since_epoch().count() : -1;
+    }
+}
+
+int main()
+{
+    std::int64_t i = 7;
+    CHECK(parse_int("-42", i) && i == -42);
+    CHECK(parse_int(" +9223372036854775807\n", i) && i == INT64_MAX);
+    CHECK(parse_int("-9223372036854775808", i) && i == INT64_MIN);
+    i = 7;
+    CHECK(!parse_int("9223372036854775808", i) && !parse_int("", i) && !parse_int("-", i));
+    CHECK(!parse_int("12a", i) && !parse_int(" 1", i, false) && i == 7);
+
+    std::uint64_t u = 7;
+    CHECK(parse_uint("18446744073709551615", u) && u == UINT64_MAX);
+    CHECK(!parse_uint("18446744073709551616", u) && !parse_uint("-1", u) && u == UINT64_MAX);
+
+    double d = 0;
+    CHECK(parse_double("1.5e3", d) && d == 1500 && parse_double(" -0.25 ", d) && d == -0.25);
+    CHECK(parse_double("INF", d) && std::isinf(d) && d > 0 && parse_double("NaN", d) && std::isnan(d));
+    CHECK(parse_double("-INF", d) && std::isinf(d) && d < 0 && parse_double("+.5", d) && d == 0.5);
+    CHECK(!parse_double("1.5x", d) && !parse_double("", d) && d == 0.5);
+    for (auto s : { "inf", "+inf", "-inf", "+INF", "Infinity", "nan", "NAN", "-NaN", "nan(1)", "-" })
+        CHECK(!parse_double(s, d) && d == 0.5);
+
+    bool b = false;
+    CHECK(parse_bool("true", b) && b && parse_bool(" 0 ", b) && !b && parse_bool("1", b) && b);
+    CHECK(!parse_bool("yes", b) && !parse_bool("TRUE", b) && b);
+
+    auto day = sys_days(year(2024) / February / 29).time_since_epoch();
+    auto t0 = duration_cast<microseconds>(day).count();
+    CHECK(micros("2024-02-29") == t0);
+    CHECK(micros("2024-02-29T01:02") == t0 + (3600 + 120) * 1000000ll);
+    CHECK(micros(" 2024-02-29T01:02:03.5Z ") == t0 + 3723500000ll);
+    CHECK(micros("2024-02-29T01:02:03.1234567") == t0 + 3723123456ll);
+    CHECK(micros("2024-02-29T01:02:03+01:00") == t0 + 123 * 1000000ll);
+    CHECK(micros("2024-02-29T01:02:03-00:30") == t0 + 5523 * 1000000ll);
+    CHECK(micros("1970-01-01T00:00:00Z") == 0);
+    for (auto bad : { "2023-02-29", "2024-13-01", "2024-04-31", "2024-01-01T24:00", "2024-01-01T12:60",
+        "2024-01-01T12:00:61", "2024-01-01T", "2024-1-01", "2024-01-01Z", "2024-01-01T12:00+1" })
+    {
+        CHECK(micros(bad) == -1);
+    }
+
+    // the getters of the parser
+    std::string_view xml = "<v i=' 12 ' d='x'> 2.5 </v>";
+    XmlParser p;
+    p.openBuffer(xml.data(), xml.size());
+    CHECK(p.next() && p.next() && p.getDouble(d) && d == 2.5 && !p.getDouble(d, false));
+    auto attributes = p.getStartTag().getAttributes();
+    CHECK(attributes.size() == 2 && attributes[0].getInt(i) && i == 12 && !attributes[1].getInt(i));
+    return test::result();
+}
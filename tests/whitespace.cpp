@@ -0,0 +1,70 @@
+// Blanks: simd::find_non_blank() at any alignment, and kTrimText and
+// kNormalizeSpace on texts, whatever the data given by feed().
+
+#include "test.h"
+#include "../simd.h"
+
+namespace
+{
+    /// Texts of a document, one per line.
+    std::string texts(std::string_view xml, int options, std::size_t pieceSize)
+    {
+        XmlParser p;
+        p.setOptions(options);
+        p.openStream();
+        std::string s;
+        for (;;)
+        {
+            if (p.next())
+            {
+                if (p.isText() || p.getItemType() == XmlParser::ItemType::kCData) s.append(p.getText()) += '|';
+                continue;
+            }
+            if (!p.needsInput()) break;
+            auto piece = xml.substr(0, pieceSize);
+            xml.remove_prefix(piece.size());
+            if (piece.empty()) p.finish();
+            else p.feed(piece.data(), piece.size());
+        }
+        return s;
+    }
+}
+
+int main()
+{
+    using char_parsers::simd::find_non_blank;
+    std::string blanks(80, ' ');
+    for (std::size_t i = 0; i != blanks.size(); ++i) blanks[i] = " \t\r\n"[i % 4];
+    for (std::size_t begin = 0; begin != 17; ++begin)
+    {
+        for (std::size_t k = begin; k <= blanks.size(); ++k)
+        {
+            auto s = blanks;
+            if (k != s.size()) s[k] = k % 2 ? 'x' : '\x80';
+            auto b = s.data() + begin, e = s.data() + s.size();
+            CHECK(find_non_blank(b, e) == s.data() + k);
+            CHECK(find_non_blank(b, s.data() + k) == s.data() + k);
+        }
+    }
+
+    std::string_view xml =
+        "<r>\n  <a>  one \t two\r\n  </a>\n"
+        "  <b>x&#32;&#32;y &amp;  z </b><c><![CDATA[  kept  as is  ]]></c>"
+        "<d> \t</d><e>                                  long                  runs                 </e></r>";
+    using O = XmlParser::Options;
+    const std::pair<int, const char*> cases[] = {
+        { 0, "one \t two\r\n  |x&#32;&#32;y &amp;  z |<![CDATA[  kept  as is  ]]>|long                  runs                 |" },
+        { O::kTrimText, "one \t two|x&#32;&#32;y &amp;  z|<![CDATA[  kept  as is  ]]>|long                  runs|" },
+        { O::kNormalizeSpace, "one two|x&#32;&#32;y &amp; z|<![CDATA[  kept  as is  ]]>|long runs|" },
+        { O::kNormalizeSpace | O::kUnescapeText, "one two|x  y & z|<![CDATA[  kept  as is  ]]>|long runs|" },
+        { O::kTrimText | O::kNormalizeSpace, "one two|x&#32;&#32;y &amp; z|<![CDATA[  kept  as is  ]]>|long runs|" },
+    };
+    for (auto& c : cases)
+    {
+        for (std::size_t pieceSize : { std::size_t(1), std::size_t(3), std::size_t(16), xml.size() })
+        {
+            CHECK(texts(xml, c.first, pieceSize) == c.second);
+        }
+    }
+    return test::result();
+}
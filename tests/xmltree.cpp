@@ -0,0 +1,53 @@
+// XmlParser::captureElement(): the tree of a record, and the parser left at
+// its end-tag.
+
+#include "test.h"
+#include "../xmltree.h"
+
+int main()
+{
+    std::string_view xml =
+        "<doc>"
+        "<rec id='1' k=\"v\">text<a>1</a><!--c--><b/><![CDATA[x<y]]></rec>"
+        "<rec id='2'/>"
+        "<after/>"
+        "</doc>";
+    XmlParser p;
+    p.openBuffer(xml.data(), xml.size());
+    XmlTree tree;
+    CHECK(p.next() && p.isElement("doc") && p.next() && p.isElement("rec"));
+    CHECK(p.captureElement(tree));
+    CHECK(p.isSuffix() && p.getName() == "rec");
+
+    auto rec = tree.getRoot();
+    CHECK(tree.size() == 7);
+    CHECK(rec.isElement() && rec.getName() == "rec" && !rec.getParent());
+    CHECK(rec.getAttributeCount() == 2);
+    CHECK(rec.getAttribute("id") == "1" && rec.getAttribute("k") == "v");
+    CHECK(rec.getAttribute(1).name == "k" && rec.getAttribute(2).name.empty());
+    CHECK(rec.getAttribute("none").empty());
+
+    auto n = rec.getFirstChild();
+    CHECK(n.isText() && n.getText() == "text");
+    n = n.getNextSibling();
+    CHECK(n.isElement() && n.getName() == "a" && n.getFirstChild().getText() == "1");
+    CHECK(n.getFirstChild().getParent().getIndex() == n.getIndex());
+    n = n.getNextSibling();
+    CHECK(n.getItemType() == XmlParser::ItemType::kComment && n.getText() == "<!--c-->");
+    n = n.getNextSibling();
+    CHECK(n.isElement() && n.getName() == "b" && !n.getFirstChild());
+    n = n.getNextSibling();
+    CHECK(n.getItemType() == XmlParser::ItemType::kCData);
+    CHECK(!n.getNextSibling());
+    CHECK(rec.getChild("b").getIndex() == 5 && !rec.getChild("c"));
+
+    // a self-closing element is a tree of one node; the tree is reused
+    CHECK(p.next() && p.isSelfClosing());
+    CHECK(p.captureElement(tree));
+    CHECK(tree.size() == 1 && tree.getRoot().getAttribute("id") == "2");
+    CHECK(p.next() && p.isElement("after"));
+
+    CHECK(p.next() && p.isSuffix());
+    CHECK(!p.captureElement(tree) && tree.empty());
+    return test::result();
+}
@@ -0,0 +1,85 @@
+// XmlWriter: markup and escaping, through a buffer small enough to be
+// flushed in the middle of items, and copying from a parser.
+
+#include "test.h"
+#include "../xmlwriter.h"
+
+namespace
+{
+    struct StringSink: XmlParser::IWriter
+    {
+        std::string s;
+        void write(const char* data, std::size_t n, std::size_t) override { s.append(data, n); }
+        using IWriter::write;
+    };
+}
+
+int main()
+{
+    StringSink sink;
+    {
+        XmlWriter w(16);
+        w.open(sink, 0);
+        w.startElement("r");
+        w.writeAttribute("a", "x\"y & <z>");
+        w.startElement("e");
+        w.endElement("e");
+        // longer than a vector, with the escaped chars at its ends
+        w.writeText("<0123456789abcdef0123456789abcdef&>");
+        w.writeCDATA("a<b");
+        w.writeComment("c");
+        w.endElement("r");
+        CHECK(!w.error());
+    }
+    CHECK(sink.s ==
+        "<r a=\"x&quot;y &amp; &lt;z&gt;\"><e/>"
+        "&lt;0123456789abcdef0123456789abcdef&amp;&gt;"
+        "<![CDATA[a<b]]><!--c--></r>");
+
+    // a copy of an element, with the text unescaped by the parser, reads the same
+    std::string_view xml = "<doc><rec id=\"1\">a &amp; b &lt; c<x/><![CDATA[<raw>]]></rec><next/></doc>";
+    XmlParser p;
+    p.setOptions(XmlParser::Options::kUnescapeText);
+    p.openBuffer(xml.data(), xml.size());
+    CHECK(p.next() && p.next() && p.isElement("rec"));
+    sink.s.clear();
+    {
+        XmlWriter w(16);
+        w.open(sink, 0);
+        CHECK(w.writeElement(p));
+    }
+    CHECK(p.isSuffix() && p.getName() == "rec");
+    CHECK(sink.s == "<rec id=\"1\">a &amp; b &lt; c<x/><![CDATA[<raw>]]></rec>");
+
+    // CDATA in pieces, with and without the tags in the text, is one block
+    std::string cdata = "<c><![CDATA[" + std::string(200, ']') + "<x>" + std::string(100, 'a') + "]]]></c>";
+    for (int options : { 0, (int)XmlParser::Options::kKeepCDATAtags })
+    {
+        for (std::size_t limit : { XmlParser::min_text_chunk, std::size_t(0) })
+        {
+            XmlParser::Limits limits;
+            limits.maxTextChunk = limit;
+            p.setLimits(limits);
+            p.setOptions(options);
+            p.openBuffer(cdata.data(), cdata.size());
+            sink.s.clear();
+            {
+                XmlWriter w(16);
+                w.open(sink, 0);
+                CHECK(p.next() && w.writeElement(p));
+            }
+            CHECK(sink.s == cdata);
+        }
+    }
+
+    // to a file
+    {
+        XmlWriter w;
+        CHECK(w.openFile("xmlwriter.xml"));
+        w.startElement("f");
+        w.writeText("1 > 0");
+        w.endElement("f");
+    }
+    CHECK(test::readFile("xmlwriter.xml") == "<f>1 &gt; 0</f>");
+    return test::result();
+}
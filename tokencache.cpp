@@ -0,0 +1,287 @@
+#include "tokencache.h"
+#include <algorithm>
+#include <cstring>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+namespace
+{
+    const char file_magic[4] = { 'X', 'T', 'C', 1 };
+    const unsigned char end_mark = 0xFF;
+
+    // flags byte: the type's bit index, then these
+    const unsigned char flag_partial = 1 << 3;
+    const unsigned char flag_continued = 1 << 4;
+    const unsigned char flag_implicit = 1 << 5;
+
+    // records are read and written through a buffer of this size at least
+    const std::size_t buffer_size = 0x10000;
+
+    // a record without its text: the flags and up to 3 varints
+    const std::size_t max_head_size = 1 + 3 * 10;
+
+    int bitIndex(int type) noexcept
+    {
+        int i = 0;
+        while (type > 1)
+        {
+            type >>= 1;
+            ++i;
+        }
+        return i;
+    }
+
+    template<class T>
+    void putField(std::pmr::string& s, T v)
+    {
+        s.append(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+
+    template<class T>
+    bool getField(std::FILE* f, T& v) noexcept
+    {
+        return fread(&v, sizeof(v), 1, f) == 1;
+    }
+
+    bool getVarint(const char*& p, const char* e, std::uint64_t& v) noexcept
+    {
+        v = 0;
+        for (int shift = 0; shift < 64 && p != e; shift += 7)
+        {
+            unsigned char c = *p++;
+            v |= std::uint64_t(c & 0x7F) << shift;
+            if (!(c & 0x80)) return true;
+        }
+        return false;
+    }
+}
+
+TokenCache::TokenCache(std::pmr::memory_resource* resource) noexcept :
+    _file(0),
+    _writing(false),
+    _error(false),
+    _data(resource),
+    _dataPos(0),
+    _lastPos(0)
+{
+}
+
+TokenCache::~TokenCache()
+{
+    close();
+}
+
+bool TokenCache::getSourceKey(const char* path, Key& key) noexcept
+{
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_stat64(path, &st) != 0 || !(st.st_mode & _S_IFREG)) return false;
+    key.mtime = st.st_mtime;
+#else
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) return false;
+#if defined(__APPLE__)
+    key.mtime = std::int64_t(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    key.mtime = std::int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+#endif
+    key.size = st.st_size;
+    return true;
+}
+
+bool TokenCache::openRead(const char* path, const Key& key) noexcept
+{
+    close();
+    _error = false;
+    try
+    {
+        _path.assign(path).append(file_suffix);
+        _data.clear();
+        _data.reserve(buffer_size);
+    }
+    catch (...)
+    {
+        return false;
+    }
+    _file = fopen(_path.c_str(), "rb");
+    if (!_file) return false;
+    char magic[sizeof(file_magic)];
+    Key k;
+    bool ok = fread(magic, sizeof(magic), 1, _file) == 1 && !memcmp(magic, file_magic, sizeof(magic)) &&
+        getField(_file, k.size) && getField(_file, k.mtime) && getField(_file, k.options) &&
+        getField(_file, k.maxTextChunk) && getField(_file, k.maxTagLength) &&
+        getField(_file, k.maxEntityExpansion) &&
+        k.size == key.size && k.mtime == key.mtime && k.sameSettings(key);
+    if (!ok)
+    {
+        close();
+        return false;
+    }
+    _key = key;
+    _writing = false;
+    _dataPos = 0;
+    _lastPos = 0;
+    return true;
+}
+
+bool TokenCache::fill(std::size_t n) noexcept
+{
+    // keeps the unread tail and appends to it, so that a record is contiguous
+    auto nLeft = _data.size() - _dataPos;
+    if (nLeft >= n) return true;
+    try
+    {
+        _data.erase(0, _dataPos);
+        _dataPos = 0;
+        auto nWant = std::max(n - nLeft, buffer_size);
+        _data.resize(nLeft + nWant);
+        auto nRead = fread(&_data[nLeft], 1, nWant, _file);
+        _data.resize(nLeft + nRead);
+    }
+    catch (...)
+    {
+        _error = true;
+        return false;
+    }
+    return _data.size() >= n;
+}
+
+bool TokenCache::read(Item& item) noexcept
+{
+    if (!isReading() || _error) return false;
+    // the head is decoded from the window at once; it is shorter only at the end
+    if (_data.size() - _dataPos < max_head_size) fill(max_head_size);
+    const char* p = _data.data() + _dataPos;
+    const char* e = _data.data() + _data.size();
+    if (p == e)
+    {
+        _error = true;  // no end mark
+        return false;
+    }
+    unsigned char flags = *p++;
+    if (flags == end_mark) return false;
+    std::uint64_t delta, length, nText = 0;
+    bool ok = getVarint(p, e, delta) && getVarint(p, e, length) &&
+        ((flags & flag_implicit) || getVarint(p, e, nText));
+    _dataPos = p - _data.data();
+    if (!ok || nText > SIZE_MAX || (_data.size() - _dataPos < nText && !fill(nText)))
+    {
+        _error = true;
+        return false;
+    }
+    item.type = 1 << (flags & 7);
+    item.partial = (flags & flag_partial) != 0;
+    item.continued = (flags & flag_continued) != 0;
+    item.implicitText = (flags & flag_implicit) != 0;
+    item.pos = _lastPos += delta;
+    item.end = item.pos + length;
+    item.text = std::string_view(_data.data() + _dataPos, nText);
+    _dataPos += nText;
+    return true;
+}
+
+bool TokenCache::openWrite(const char* path, const Key& key) noexcept
+{
+    close();
+    _error = false;
+    try
+    {
+        _path.assign(path).append(file_suffix);
+        _tmpPath.assign(_path).append(".tmp");
+        _data.clear();
+        _data.reserve(buffer_size * 2);
+        _data.append(file_magic, sizeof(file_magic));
+        putField(_data, key.size);
+        putField(_data, key.mtime);
+        putField(_data, key.options);
+        putField(_data, key.maxTextChunk);
+        putField(_data, key.maxTagLength);
+        putField(_data, key.maxEntityExpansion);
+    }
+    catch (...)
+    {
+        return false;
+    }
+    _file = fopen(_tmpPath.c_str(), "wb");
+    if (!_file) return false;
+    _key = key;
+    _writing = true;
+    _lastPos = 0;
+    return true;
+}
+
+void TokenCache::putVarint(std::uint64_t v)
+{
+    for (; v >= 0x80; v >>= 7) _data += char(v | 0x80);
+    _data += char(v);
+}
+
+void TokenCache::flush() noexcept
+{
+    if (!_data.empty() && fwrite(_data.data(), 1, _data.size(), _file) != _data.size()) _error = true;
+    _data.clear();
+}
+
+void TokenCache::write(const Item& item) noexcept
+{
+    if (!isWriting() || _error) return;
+    unsigned char flags = bitIndex(item.type);
+    if (item.partial) flags |= flag_partial;
+    if (item.continued) flags |= flag_continued;
+    if (item.implicitText) flags |= flag_implicit;
+    try
+    {
+        _data += char(flags);
+        putVarint(item.pos - _lastPos);
+        putVarint(item.end - item.pos);
+        if (!item.implicitText)
+        {
+            putVarint(item.text.size());
+            _data.append(item.text);
+        }
+    }
+    catch (...)
+    {
+        _error = true;
+        return;
+    }
+    _lastPos = item.pos;
+    if (_data.size() >= buffer_size) flush();
+}
+
+bool TokenCache::commit() noexcept
+{
+    if (!isWriting()) return false;
+    try
+    {
+        _data += char(end_mark);
+    }
+    catch (...)
+    {
+        _error = true;
+    }
+    flush();
+    if (fclose(_file) != 0) _error = true;
+    _file = 0;
+    if (!_error)
+    {
+        // the cache appears whole or not at all
+#ifdef _WIN32
+        remove(_path.c_str());  // rename() does not replace files there
+#endif
+        if (rename(_tmpPath.c_str(), _path.c_str()) == 0) return true;
+        _error = true;
+    }
+    remove(_tmpPath.c_str());
+    return false;
+}
+
+void TokenCache::close() noexcept
+{
+    if (!_file) return;
+    fclose(_file);
+    _file = 0;
+    if (_writing) remove(_tmpPath.c_str());
+    _writing = false;
+}
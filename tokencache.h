@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+/// Binary file of the items of an XML file, kept next to it ("<path>.xtc"),
+/// so that later parses of the same file replay the items instead of
+/// tokenizing the XML. The file is valid for a source of the same size and
+/// modification time, parsed with the same settings (see Key).
+///
+/// Records are: a flags byte (type, partial and continuation bits), the
+/// item's position as a delta from the previous one and its source length,
+/// as LEB128 varints, and the length-prefixed text. End-tags of the form
+/// "</name>" have no text; the name is known from the path.
+class TokenCache
+{
+    public:
+
+    static constexpr const char* file_suffix = ".xtc";
+
+    /// What the items depend on; a cache is read only if all of it matches.
+    struct Key
+    {
+        std::uint64_t size = 0;       // of the source
+        std::int64_t mtime = 0;       // of the source; as precise as the system gives
+        std::int32_t options = 0;     // XmlParser::Options which change the items
+        std::uint64_t maxTextChunk = 0;
+        std::uint64_t maxTagLength = 0;
+        std::uint64_t maxEntityExpansion = 0;
+
+        /// True if the settings, i.e. all but the size and the time, are the same.
+        bool sameSettings(const Key& k) const noexcept
+        {
+            return options == k.options && maxTextChunk == k.maxTextChunk &&
+                maxTagLength == k.maxTagLength && maxEntityExpansion == k.maxEntityExpansion;
+        }
+    };
+
+    /// Item record.
+    struct Item
+    {
+        int type = 0;                // XmlParser::ItemType
+        bool partial = false;        // see XmlParser::isPartial()
+        bool continued = false;      // see XmlParser::isContinuation()
+        bool implicitText = false;   // an end-tag "</name>" of the current element
+        std::uint64_t pos = 0;       // of the item in the source
+        std::uint64_t end = 0;       // position after the item in the source
+        std::string_view text;       // empty with implicitText; valid until the next read()
+    };
+
+    /// Constructor.
+    ///\ param resource Memory resource of the read and write buffers.
+    TokenCache(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) noexcept;
+    TokenCache(const TokenCache&) = delete;
+    TokenCache& operator=(const TokenCache&) = delete;
+
+    /// Destructor. Discards a cache being written.
+    ~TokenCache();
+
+    /// Sets the size and the modification time of a source file in a key.
+    /// \return False if the file cannot be examined.
+    static bool getSourceKey(const char* path, Key& key) noexcept;
+
+    /// Opens the cache of a source file for reading, if it exists and has
+    /// the key given.
+    bool openRead(const char* path, const Key& key) noexcept;
+
+    /// Reads the next item.
+    /// \return False at the end of the cache or on error (see error()).
+    bool read(Item& item) noexcept;
+
+    /// Starts writing the cache of a source file, to a temporary file which
+    /// replaces the cache by commit().
+    bool openWrite(const char* path, const Key& key) noexcept;
+
+    /// Appends an item; items come in the order of the source.
+    void write(const Item& item) noexcept;
+
+    /// Finishes writing and replaces the previous cache, if any.
+    /// \return False on a write error; the cache is discarded then.
+    bool commit() noexcept;
+
+    /// Closes the file; a cache being written is discarded.
+    void close() noexcept;
+
+    bool isReading() const noexcept { return _file && !_writing; }
+    bool isWriting() const noexcept { return _file && _writing; }
+
+    /// True if reading or writing failed, e.g. the cache is truncated.
+    bool error() const noexcept { return _error; }
+
+    /// The key of the cache open.
+    const Key& getKey() const noexcept { return _key; }
+
+    private:
+
+    std::FILE* _file;
+    bool _writing;
+    bool _error;
+    Key _key;
+    std::string _path;          // of the cache
+    std::string _tmpPath;       // of the cache being written
+    std::pmr::string _data;     // read window or write buffer
+    std::size_t _dataPos;       // read position in _data
+    std::uint64_t _lastPos;     // position of the previous item
+
+    bool fill(std::size_t n) noexcept;
+    void putVarint(std::uint64_t v);
+    void flush() noexcept;
+};
@@ -0,0 +1,354 @@
+// xmlbench: measures parsing of a corpus by this build of XmlParser, by other
+// builds of it and by reference parsers found on the system.
+//
+//     xmlbench [--workload scan|text|attributes|batch] [--repeat N] [--structural]
+//              [--build PATH]... [--no-reference] <file>...
+//
+// The batch workload loads the items with XmlParser::nextBatch(), into arrays
+// of batch_size items; reference parsers run the scan workload for it.
+// --structural runs XmlParser with Options::kStructuralIndex; comparing a 
+// run with it to one without shows what the index gains on the corpus.
+//
+// Each engine runs in a child process of its own, so that peak memory is
+// measured per engine: this build, each other build of xmlbench given by
+// --build (e.g. one built from a saved baseline), and reference parsers:
+// expat and pugixml, if built with XMLBENCH_WITH_EXPAT and XMLBENCH_WITH_PUGIXML
+// defined and linked with their libraries (the CMake options of the same
+// names do both). Results are printed as a table of throughput, time
+// per item and peak memory; times are the mean and standard deviation of
+// the repetitions, each of which parses the whole corpus.
+//
+// Items are what each engine reports: XmlParser items, expat callbacks,
+// pugixml nodes; the time per item is comparable only roughly.
+
+#include "../processor.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#define popen _popen
+#define pclose _pclose
+#else
+#include <sys/resource.h>
+#endif
+
+#ifdef XMLBENCH_WITH_EXPAT
+#include <expat.h>
+#endif
+
+#ifdef XMLBENCH_WITH_PUGIXML
+#include <pugixml.hpp>
+#endif
+
+namespace
+{
+
+enum class Workload { kScan, kText, kAttributes, kBatch };
+
+const std::size_t batch_size = 1024;
+
+volatile std::size_t sink_total = 0;  // keeps the workloads from being optimized away
+
+struct Result
+{
+    std::uint64_t bytes = 0;
+    std::uint64_t items = 0;
+    double mean = 0;     // seconds per repetition
+    double stddev = 0;
+    double peakMB = 0;
+    bool ok = false;
+};
+
+int usage()
+{
+    std::cerr << "usage: xmlbench [--workload scan|text|attributes|batch] [--repeat N] [--structural] "
+        "[--build PATH]... [--no-reference] <file>...\n";
+    return 2;
+}
+
+double peakMemoryMB()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+    return pmc.PeakWorkingSetSize / 1048576.0;
+#else
+    rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+#ifdef __APPLE__
+    return ru.ru_maxrss / 1048576.0;  // bytes
+#else
+    return ru.ru_maxrss / 1024.0;     // kilobytes
+#endif
+#endif
+}
+
+std::uint64_t fileSize(const std::string& path)
+{
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return 0;
+    std::uint64_t n = 0;
+    char buf[0x10000];
+    for (std::size_t r; (r = fread(buf, 1, sizeof(buf), f)) != 0; ) n += r;
+    fclose(f);
+    return n;
+}
+
+//=====================     Engines    ==================================//
+
+// Each one parses a file and returns the number of items, or -1 on error.
+
+std::int64_t runXmlParser(XmlParser& p, XmlParser::TokenBatch& batch, const std::string& path,
+    Workload w, int options)
+{
+    p.setOptions(options | (w == Workload::kText ? XmlParser::Options::kUnescapeText : 0));
+    if (!p.openFile(path.c_str())) return -1;
+    std::int64_t n = 0;
+    std::size_t sink = 0;
+    if (w == Workload::kBatch)
+    {
+        while (auto k = p.nextBatch(batch, batch_size))
+        {
+            n += k;
+            sink += batch.chars.size();
+        }
+    }
+    else while (p.next())
+    {
+        ++n;
+        if (w == Workload::kText && p.isText()) sink += p.getText().size();
+        else if (w == Workload::kAttributes && p.isElement() && !p.isSuffix())
+        {
+            p.getStartTag().forEachAttribute([&sink](const XmlParser::Attribute& a)
+            {
+                sink += a.value.size();
+            });
+        }
+    }
+    bool ok = !p.error();
+    p.closeFile();
+    sink_total = sink_total + sink;
+    return ok ? n : -1;
+}
+
+#ifdef XMLBENCH_WITH_EXPAT
+std::int64_t runExpat(const std::string& path, Workload w)
+{
+    struct State { std::int64_t n = 0; std::size_t sink = 0; Workload w; } st;
+    st.w = w;
+    auto parser = XML_ParserCreate(0);
+    XML_SetUserData(parser, &st);
+    XML_SetElementHandler(parser, [](void* d, const XML_Char*, const XML_Char** attrs)
+    {
+        auto& s = *static_cast<State*>(d);
+        ++s.n;
+        if (s.w == Workload::kAttributes)
+            for (; *attrs; attrs += 2) s.sink += strlen(attrs[1]);
+    }, [](void* d, const XML_Char*) { ++static_cast<State*>(d)->n; });
+    XML_SetCharacterDataHandler(parser, [](void* d, const XML_Char*, int len)
+    {
+        auto& s = *static_cast<State*>(d);
+        ++s.n;
+        s.sink += len;
+    });
+    FILE* f = fopen(path.c_str(), "rb");
+    bool ok = f != 0;
+    while (ok)
+    {
+        auto buf = XML_GetBuffer(parser, XmlParser::default_chunk_size);
+        auto r = fread(buf, 1, XmlParser::default_chunk_size, f);
+        ok = XML_ParseBuffer(parser, (int)r, r == 0) == XML_STATUS_OK;
+        if (!r) break;
+    }
+    if (f) fclose(f);
+    XML_ParserFree(parser);
+    sink_total = sink_total + st.sink;
+    return ok ? st.n : -1;
+}
+#endif
+
+#ifdef XMLBENCH_WITH_PUGIXML
+std::int64_t runPugixml(const std::string& path, Workload w)
+{
+    pugi::xml_document doc;
+    auto options = pugi::parse_default;
+    if (w != Workload::kText) options &= ~pugi::parse_escapes;
+    if (!doc.load_file(path.c_str(), options)) return -1;
+    struct Walker: pugi::xml_tree_walker
+    {
+        std::int64_t n = 0;
+        std::size_t sink = 0;
+        Workload w;
+        bool for_each(pugi::xml_node& node) override
+        {
+            ++n;
+            if (w == Workload::kAttributes)
+                for (auto a : node.attributes()) sink += strlen(a.value());
+            else if (w == Workload::kText) sink += strlen(node.value());
+            return true;
+        }
+    } walker;
+    walker.w = w;
+    doc.traverse(walker);
+    sink_total = sink_total + walker.sink;
+    return walker.n;
+}
+#endif
+
+/// Runs an engine in this process and prints its result line.
+int runChild(const std::string& engine, Workload w, int options, int repeat, 
+    const std::vector<std::string>& files)
+{
+    XmlParser parser;
+    XmlParser::TokenBatch batch;
+    std::vector<double> times;
+    std::int64_t items = 0;
+    for (int r = 0; r != repeat; ++r)
+    {
+        items = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (auto& path : files)
+        {
+            std::int64_t n = -1;
+            if (engine == "xmlparser") n = runXmlParser(parser, batch, path, w, options);
+#ifdef XMLBENCH_WITH_EXPAT
+            else if (engine == "expat") n = runExpat(path, w);
+#endif
+#ifdef XMLBENCH_WITH_PUGIXML
+            else if (engine == "pugixml") n = runPugixml(path, w);
+#endif
+            if (n < 0)
+            {
+                std::cout << "FAILED " << path << '\n';
+                return 1;
+            }
+            items += n;
+        }
+        times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+    }
+    double mean = 0, var = 0;
+    for (auto t : times) mean += t;
+    mean /= times.size();
+    for (auto t : times) var += (t - mean) * (t - mean);
+    var = times.size() > 1 ? var / (times.size() - 1) : 0;
+    std::cout << "RESULT " << items << ' ' << mean << ' ' << std::sqrt(var) << ' '
+        << peakMemoryMB() << '\n';
+    return 0;
+}
+
+std::string quote(const std::string& s)
+{
+#ifdef _WIN32
+    return '"' + s + '"';
+#else
+    std::string q = "'";
+    for (char c : s) q += c == '\'' ? std::string("'\\''") : std::string(1, c);
+    return q + '\'';
+#endif
+}
+
+/// Runs an engine of a build in a child process.
+Result runEngine(const std::string& build, const std::string& engine, const std::string& args)
+{
+    Result r;
+    auto cmd = quote(build) + " --child " + engine + args;
+    FILE* child = popen(cmd.c_str(), "r");
+    if (!child) return r;
+    char line[512];
+    while (fgets(line, sizeof(line), child))
+    {
+        unsigned long long items;
+        if (sscanf(line, "RESULT %llu %lf %lf %lf", &items, &r.mean, &r.stddev, &r.peakMB) == 4)
+        {
+            r.items = items;
+            r.ok = true;
+        }
+    }
+    r.ok &= pclose(child) == 0;
+    return r;
+}
+
+void printRow(const std::string& name, const Result& r)
+{
+    char row[256];
+    if (!r.ok) snprintf(row, sizeof(row), "%-36s  failed\n", name.c_str());
+    else snprintf(row, sizeof(row), "%-36s %9.1f %7.1f %8.2f %8.1f %10.1f\n", name.c_str(),
+        r.bytes / r.mean / 1048576.0, r.bytes * r.stddev / (r.mean * r.mean) / 1048576.0,
+        r.mean * 1e3, r.items ? r.mean * 1e9 / r.items : 0.0, r.peakMB);
+    std::cout << row;
+}
+
+} // end namespace
+
+int main(int argc, char** argv)
+{
+    Workload workload = Workload::kScan;
+    int repeat = 5;
+    int options = 0;
+    bool reference = true;
+    std::string child, workloadName = "scan";
+    std::vector<std::string> builds{ argv[0] }, files;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (a == "--workload" && hasValue)
+        {
+            workloadName = argv[++i];
+            if (workloadName == "scan") workload = Workload::kScan;
+            else if (workloadName == "text") workload = Workload::kText;
+            else if (workloadName == "attributes") workload = Workload::kAttributes;
+            else if (workloadName == "batch") workload = Workload::kBatch;
+            else return usage();
+        }
+        else if (a == "--repeat" && hasValue) repeat = std::max(1, atoi(argv[++i]));
+        else if (a == "--build" && hasValue) builds.push_back(argv[++i]);
+        else if (a == "--child" && hasValue) child = argv[++i];
+        else if (a == "--structural") options |= XmlParser::Options::kStructuralIndex;
+        else if (a == "--no-reference") reference = false;
+        else if (a.size() > 1 && a[0] == '-' && a[1] == '-') return usage();
+        else files.push_back(a);
+    }
+    if (files.empty()) return usage();
+    if (!child.empty()) return runChild(child, workload, options, repeat, files);
+
+    std::uint64_t bytes = 0;
+    for (auto& f : files) bytes += fileSize(f);
+    std::string args = " --workload " + workloadName + " --repeat " + std::to_string(repeat);
+    if (options & XmlParser::Options::kStructuralIndex) args += " --structural";
+    for (auto& f : files) args += ' ' + quote(f);
+
+    std::cout << files.size() << " files, " << bytes / 1048576.0 << " MB, workload "
+        << workloadName << (options ? " with the structural index" : "") << ", " 
+        << repeat << " repetitions\n\n";
+    std::cout << "engine                                    MB/s     +/-  ms/pass  ns/item  peak MB\n";
+    for (std::size_t i = 0; i != builds.size(); ++i)
+    {
+        auto r = runEngine(builds[i], "xmlparser", args);
+        r.bytes = bytes;
+        printRow(i ? "XmlParser " + builds[i] : std::string("XmlParser (this build)"), r);
+    }
+    if (reference)
+    {
+#ifdef XMLBENCH_WITH_EXPAT
+        auto r = runEngine(argv[0], "expat", args);
+        r.bytes = bytes;
+        printRow("expat", r);
+#endif
+#ifdef XMLBENCH_WITH_PUGIXML
+        auto r2 = runEngine(argv[0], "pugixml", args);
+        r2.bytes = bytes;
+        printRow("pugixml", r2);
+#endif
+    }
+    return 0;
+}
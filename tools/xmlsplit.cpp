@@ -0,0 +1,51 @@
+// xmlsplit: splits an XML document into well-formed shards of whole records.
+//
+//     xmlsplit <input> <output-prefix> <shards> [--level N] [--record NAME] 
+//              [--key ATTRIBUTE] [--threads N]
+//
+// Shards are written to <output-prefix>0.xml, <output-prefix>1.xml etc.
+
+#include "../splitter.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+static int usage()
+{
+    std::cerr << "usage: xmlsplit <input> <output-prefix> <shards> [--level N] "
+        "[--record NAME] [--key ATTRIBUTE] [--threads N]\n";
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 4) return usage();
+    auto nShards = strtoul(argv[3], 0, 10);
+    if (!nShards) return usage();
+
+    XmlSplitter splitter;
+    for (int i = 4; i < argc; i += 2)
+    {
+        if (i + 1 == argc) return usage();
+        const char* v = argv[i + 1];
+        if (!strcmp(argv[i], "--level")) splitter.setRecordLevel(strtoul(v, 0, 10));
+        else if (!strcmp(argv[i], "--record")) splitter.setRecordName(v);
+        else if (!strcmp(argv[i], "--key")) splitter.setKeyAttribute(v);
+        else if (!strcmp(argv[i], "--threads")) splitter.setThreadCount(strtoul(v, 0, 10));
+        else return usage();
+    }
+
+    std::vector<std::string> outputs;
+    for (unsigned long i = 0; i != nShards; ++i)
+    {
+        outputs.push_back(std::string(argv[2]) + std::to_string(i) + ".xml");
+    }
+
+    if (!splitter.split(argv[1], outputs))
+    {
+        std::cerr << "xmlsplit: failed, error code " << (int)splitter.getErrorCode() << '\n';
+        return 1;
+    }
+    std::cout << splitter.getRecordCount() << " records written\n";
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include "values.h"
+#include <charconv>
+#include <limits>
+
+namespace char_parsers
+{
+
+namespace
+{
+    bool is_blank(char c) noexcept
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    // from_chars does not take a leading '+'
+    std::string_view skip_plus(std::string_view s) noexcept
+    {
+        if (s.size() > 1 && s[0] == '+' && s[1] != '-') s.remove_prefix(1);
+        return s;
+    }
+
+    // fixed-width decimal field; advances s
+    bool take_digits(std::string_view& s, std::size_t n, int& v) noexcept
+    {
+        if (s.size() < n) return false;
+        v = 0;
+        for (std::size_t i = 0; i != n; ++i)
+        {
+            if (s[i] < '0' || s[i] > '9') return false;
+            v = v * 10 + (s[i] - '0');
+        }
+        s.remove_prefix(n);
+        return true;
+    }
+
+    bool take_char(std::string_view& s, char c) noexcept
+    {
+        if (s.empty() || s[0] != c) return false;
+        s.remove_prefix(1);
+        return true;
+    }
+
+    // of a proleptic Gregorian year; 0 is 1 BC, a leap year
+    int days_in_month(std::int64_t y, int m) noexcept
+    {
+        static const int days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+        bool leap = y % 4 == 0 && (y % 100 != 0 || y % 400 == 0);
+        return m == 2 && leap ? 29 : days[m - 1];
+    }
+
+    // days since 1970-01-01 of a proleptic Gregorian date
+    std::int64_t days_from_civil(std::int64_t y, int m, int d) noexcept
+    {
+        y -= m <= 2;
+        auto era = (y >= 0 ? y : y - 399) / 400;
+        auto yoe = y - era * 400;
+        auto doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+        auto doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + doe - 719468;
+    }
+}
+
+std::string_view trim_blanks(std::string_view s) noexcept
+{
+    while (!s.empty() && is_blank(s.front())) s.remove_prefix(1);
+    while (!s.empty() && is_blank(s.back())) s.remove_suffix(1);
+    return s;
+}
+
+bool parse_int(std::string_view s, std::int64_t& v, bool trim) noexcept
+{
+    if (trim) s = trim_blanks(s);
+    s = skip_plus(s);
+    std::int64_t x;
+    auto r = std::from_chars(s.data(), s.data() + s.size(), x);
+    if (r.ec != std::errc() || r.ptr != s.data() + s.size()) return false;
+    v = x;
+    return true;
+}
+
+bool parse_uint(std::string_view s, std::uint64_t& v, bool trim) noexcept
+{
+    if (trim) s = trim_blanks(s);
+    s = skip_plus(s);
+    if (!s.empty() && s[0] == '-') return false;
+    std::uint64_t x;
+    auto r = std::from_chars(s.data(), s.data() + s.size(), x);
+    if (r.ec != std::errc() || r.ptr != s.data() + s.size()) return false;
+    v = x;
+    return true;
+}
+
+bool parse_double(std::string_view s, double& v, bool trim) noexcept
+{
+    if (trim) s = trim_blanks(s);
+    // xs:double spellings; any other "inf", "infinity" or "nan(...)" from_chars 
+    // would take is rejected by requiring a digit or '.' after the sign
+    if (s == "INF") { v = std::numeric_limits<double>::infinity(); return true; }
+    if (s == "-INF") { v = -std::numeric_limits<double>::infinity(); return true; }
+    if (s == "NaN") { v = std::numeric_limits<double>::quiet_NaN(); return true; }
+    s = skip_plus(s);
+    auto digits = s.substr(!s.empty() && s[0] == '-');
+    if (digits.empty() || !(digits[0] == '.' || (digits[0] >= '0' && digits[0] <= '9'))) 
+        return false;
+    double x;
+    auto r = std::from_chars(s.data(), s.data() + s.size(), x);
+    if (r.ec != std::errc() || r.ptr != s.data() + s.size()) return false;
+    v = x;
+    return true;
+}
+
+bool parse_bool(std::string_view s, bool& v, bool trim) noexcept
+{
+    if (trim) s = trim_blanks(s);
+    if (s == "true" || s == "1") v = true;
+    else if (s == "false" || s == "0") v = false;
+    else return false;
+    return true;
+}
+
+bool parse_timestamp(std::string_view s, timestamp& v, bool trim) noexcept
+{
+    if (trim) s = trim_blanks(s);
+    int sign = take_char(s, '-') ? -1 : 1;
+    int year, month, day, hour = 0, minute = 0, second = 0;
+    std::int64_t us = 0;
+    if (!take_digits(s, 4, year) || !take_char(s, '-') || !take_digits(s, 2, month) ||
+        !take_char(s, '-') || !take_digits(s, 2, day)) return false;
+    if (month < 1 || month > 12 || day < 1 || day > days_in_month(sign * year, month)) return false;
+    if (take_char(s, 'T') || take_char(s, 't') || take_char(s, ' '))
+    {
+        if (!take_digits(s, 2, hour) || !take_char(s, ':') || !take_digits(s, 2, minute)) return false;
+        bool hasSeconds = take_char(s, ':');
+        if (hasSeconds)
+        {
+            if (!take_digits(s, 2, second)) return false;
+            if (take_char(s, '.') || take_char(s, ','))
+            {
+                int digit, n = 0;
+                while (take_digits(s, 1, digit))
+                {
+                    if (n++ < 6) us = us * 10 + digit; // finer digits are truncated
+                }
+                if (!n) return false;
+                for (; n < 6; ++n) us *= 10;
+            }
+        }
+        // 24:00:00 is the end of the day, written so only; 60 is a leap second
+        if (hour > 24 || minute > 59 || second > 60) return false;
+        if (hour == 24 && (!hasSeconds || minute || second || us)) return false;
+        int zone = take_char(s, '+') ? 1 : take_char(s, '-') ? -1 : 0;
+        if (zone)
+        {
+            int zh, zm;
+            if (!take_digits(s, 2, zh) || !take_char(s, ':') || !take_digits(s, 2, zm)) return false;
+            if (zh > 14 || zm > 59 || (zh == 14 && zm)) return false;
+            minute -= zone * (zh * 60 + zm);
+        }
+        else if (!take_char(s, 'Z')) take_char(s, 'z');
+    }
+    if (!s.empty()) return false;
+    auto days = days_from_civil(sign * static_cast<std::int64_t>(year), month, day);
+    auto secs = ((days * 24 + hour) * 60 + minute) * 60 + second;
+    v = timestamp(std::chrono::microseconds(secs * 1000000 + us));
+    return true;
+}
+
+}; // end namespace
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+namespace char_parsers
+{
+
+/// \brief Parsers of typed values from text spans, working in place.
+/// \detail Each parser succeeds only if the whole span is the value; if
+/// trim is true, XML blanks (space, tab, CR, LF) around it are ignored.
+/// On failure, the value is not changed.
+
+/// Microseconds since 1970-01-01T00:00:00Z.
+using timestamp = std::chrono::time_point<std::chrono::system_clock, std::chrono::microseconds>;
+
+/// Removes leading and trailing XML blanks.
+std::string_view trim_blanks(std::string_view s) noexcept;
+
+/// Decimal integer with optional sign.
+bool parse_int(std::string_view s, std::int64_t& v, bool trim = true) noexcept;
+
+/// Decimal unsigned integer with optional '+'.
+bool parse_uint(std::string_view s, std::uint64_t& v, bool trim = true) noexcept;
+
+/// Floating-point number in fixed or scientific form, or "INF", "-INF", "NaN".
+bool parse_double(std::string_view s, double& v, bool trim = true) noexcept;
+
+/// "true", "false", "1" or "0", as xs:boolean.
+bool parse_bool(std::string_view s, bool& v, bool trim = true) noexcept;
+
+/// ISO-8601 date or date-time: "YYYY-MM-DD[Thh:mm[:ss[.f...]][Z|+hh:mm|-hh:mm]]";
+/// a date-time without a zone designator is taken as UTC.
+bool parse_timestamp(std::string_view s, timestamp& v, bool trim = true) noexcept;
+
+}; // end namespace
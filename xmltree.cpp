@@ -0,0 +1,95 @@
+#include "xmltree.h"
+
+//=====================     Tree    ==================================//
+
+void XmlTree::clear() noexcept
+{
+    _nodes.clear();
+    _attributes.clear();
+    _chars.clear();
+    _stack.clear();
+}
+
+XmlTree::Span XmlTree::store(std::string_view s) noexcept
+{
+    Span span{ (index_type)_chars.size(), (index_type)s.size() };
+    _chars.append(s);
+    return span;
+}
+
+XmlTree::index_type XmlTree::addNode(XmlParser::ItemType type, index_type parent) noexcept
+{
+    auto i = (index_type)_nodes.size();
+    _nodes.push_back(Node{ type, parent, npos, npos, npos, Span{0, 0}, Span{0, 0}, 0, 0 });
+    if (parent != npos)
+    {
+        auto& p = _nodes[parent];
+        if (p.lastChild != npos) _nodes[p.lastChild].nextSibling = i;
+        else p.firstChild = i;
+        p.lastChild = i;
+    }
+    return i;
+}
+
+XmlParser::Attribute XmlTree::reference::getAttribute(std::size_t i) const noexcept
+{
+    if (i >= getAttributeCount()) return XmlParser::Attribute{};
+    auto& a = _tree->_attributes[node().firstAttribute + i];
+    return XmlParser::Attribute{ _tree->view(a.name), _tree->view(a.value) };
+}
+
+std::string_view XmlTree::reference::getAttribute(std::string_view name) const noexcept
+{
+    for (std::size_t i = 0; i != getAttributeCount(); ++i)
+    {
+        auto a = getAttribute(i);
+        if (a.name == name) return a.value;
+    }
+    return std::string_view();
+}
+
+XmlTree::reference XmlTree::reference::getChild(std::string_view name) const noexcept
+{
+    auto it = getFirstChild();
+    while (it && !(it.isElement() && it.getName() == name)) it = it.getNextSibling();
+    return it;
+}
+
+//=====================     Capture    ==================================//
+
+bool XmlParser::captureElement(XmlTree& tree) noexcept
+{
+    tree.clear();
+    if (!isElement()) return false;
+    for (;;)
+    {
+        auto parent = tree._stack.empty() ? XmlTree::npos : tree._stack.back();
+        if (isElement())
+        {
+            auto i = tree.addNode(ItemType::kPrefix, parent);
+            auto tag = getStartTag();
+            auto first = tree._attributes.size();
+            tag.forEachAttribute([&tree](const Attribute& a)
+            {
+                auto name = tree.store(a.name);
+                tree._attributes.push_back(XmlTree::AttributeNode{ name, tree.store(a.value) });
+            });
+            auto& node = tree._nodes[i];
+            node.name = tree.store(tag.getName());
+            node.firstAttribute = (XmlTree::index_type)first;
+            node.nAttributes = (XmlTree::index_type)(tree._attributes.size() - first);
+            if (isPrefix()) tree._stack.push_back(i);
+        }
+        else if (isSuffix())
+        {
+            tree._stack.pop_back();
+        }
+        else
+        {
+            auto i = tree.addNode(_itemType, parent);
+            tree._nodes[i].text = tree.store(_text);
+        }
+        if (tree._stack.empty()) return true; // the end-tag or a self-closing tag
+        if (!next()) return false;
+    }
+}
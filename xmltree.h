@@ -0,0 +1,132 @@
+#pragma once
+
+#include "processor.h"
+#include <cstdint>
+
+/// Read-only compact tree of an element's subtree, made by
+/// XmlParser::captureElement().
+/// \detail Nodes, attributes and characters are stored in three contiguous
+/// arrays linked by indices rather than pointers. clear() keeps the memory,
+/// so that one tree can be reused for any number of records without freeing.
+class XmlTree
+{
+    public:
+
+    using index_type = std::uint32_t;
+    static const index_type npos = ~index_type(0);
+
+    private:
+
+    struct Span
+    {
+        index_type offset;
+        index_type size;
+    };
+
+    struct Node
+    {
+        XmlParser::ItemType type;
+        index_type parent;
+        index_type firstChild;
+        index_type lastChild;
+        index_type nextSibling;
+        Span name;
+        Span text;
+        index_type firstAttribute;
+        index_type nAttributes;
+    };
+
+    struct AttributeNode
+    {
+        Span name;
+        Span value;
+    };
+
+    public:
+
+    /// Constructor.
+    ///\ param resource Memory resource for nodes, attributes and characters.
+    XmlTree(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) noexcept:
+        _nodes(resource), _attributes(resource), _chars(resource), _stack(resource) {}
+
+    /// Lightweight handle of a node; valid while the tree is not cleared.
+    class reference
+    {
+        public:
+
+        /// True if refers to an existing node
+        explicit operator bool() const noexcept { return _idx != npos; }
+
+        /// Index of the node; the root is 0
+        index_type getIndex() const noexcept { return _idx; }
+
+        /// kPrefix for elements; kEscapedText, kCData, kPI or kComment otherwise
+        XmlParser::ItemType getItemType() const noexcept { return node().type; }
+
+        bool isElement() const noexcept
+        { return getItemType() == XmlParser::ItemType::kPrefix; }
+
+        bool isText() const noexcept
+        { return ((int)getItemType() & ((int)XmlParser::ItemType::kEscapedText |
+            (int)XmlParser::ItemType::kCData)); }
+
+        /// Element's name; empty for other nodes
+        std::string_view getName() const noexcept { return _tree->view(node().name); }
+
+        /// Item's text (see XmlParser::getText()); empty for elements
+        std::string_view getText() const noexcept { return _tree->view(node().text); }
+
+        /// Number of element's attributes
+        std::size_t getAttributeCount() const noexcept { return node().nAttributes; }
+
+        /// Gets an attribute by its number; safe: returns empty one when out-of-bounds.
+        XmlParser::Attribute getAttribute(std::size_t i) const noexcept;
+
+        /// Gets the value of an attribute by its name; empty if not found.
+        std::string_view getAttribute(std::string_view name) const noexcept;
+
+        reference getParent() const noexcept { return reference(_tree, node().parent); }
+        reference getFirstChild() const noexcept { return reference(_tree, node().firstChild); }
+        reference getNextSibling() const noexcept { return reference(_tree, node().nextSibling); }
+
+        /// Gets the first child element of a given name.
+        reference getChild(std::string_view name) const noexcept;
+
+        private:
+        friend class XmlTree;
+        reference(const XmlTree* tree, index_type i) noexcept: _tree(tree), _idx(i) {}
+        const Node& node() const noexcept { return _tree->_nodes[_idx]; }
+        const XmlTree* _tree;
+        index_type _idx;
+    };
+
+    /// True if nothing captured
+    bool empty() const noexcept { return _nodes.empty(); }
+
+    /// Number of nodes, including the root
+    std::size_t size() const noexcept { return _nodes.size(); }
+
+    /// The captured element
+    reference getRoot() const noexcept { return reference(this, empty() ? npos : 0); }
+
+    /// Gets a node by its index; nodes are numbered in document order.
+    reference operator[](std::size_t i) const noexcept
+    { return reference(this, i < size() ? (index_type)i : npos); }
+
+    /// Removes all nodes but keeps the allocated memory.
+    void clear() noexcept;
+
+    private:
+
+    friend class XmlParser;
+
+    std::pmr::vector<Node> _nodes;
+    std::pmr::vector<AttributeNode> _attributes;
+    std::pmr::string _chars;
+    std::pmr::vector<index_type> _stack;  // open elements while capturing
+
+    std::string_view view(Span s) const noexcept
+    { return std::string_view(_chars.data() + s.offset, s.size); }
+    Span store(std::string_view s) noexcept;
+    index_type addNode(XmlParser::ItemType type, index_type parent) noexcept;
+};
@@ -0,0 +1,214 @@
+#include "xmlwriter.h"
+#include "simd.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace char_parsers;
+
+//=====================     Initialization    ==================================//
+
+XmlWriter::XmlWriter(std::size_t bufferSize) noexcept :
+    _capacity(std::max<std::size_t>(bufferSize, 0x100)),
+    _size(0),
+    _output(0),
+    _sink(0),
+    _sinkIndex(0),
+    _error(false),
+    _tagOpen(false)
+{
+    _buffer = new char[_capacity];
+}
+
+bool XmlWriter::openFile(const char* path) noexcept
+{
+    closeFile();
+    _error = false;
+    _output = fopen(path, "wb");
+    if (_output && setvbuf(_output, nullptr, _IONBF, 0) == 0) return true;
+    if (_output) fclose(_output);
+    _output = 0;
+    _error = true;
+    return false;
+}
+
+void XmlWriter::open(IWriter& sink, std::size_t userIndex) noexcept
+{
+    closeFile();
+    _error = false;
+    _sink = &sink;
+    _sinkIndex = userIndex;
+}
+
+void XmlWriter::closeFile() noexcept
+{
+    closeTag();
+    flush();
+    if (_output) fclose(_output);
+    _output = 0;
+    _sink = 0;
+}
+
+XmlWriter::~XmlWriter()
+{
+    closeFile();
+    delete[] _buffer;
+}
+
+bool XmlWriter::flush() noexcept
+{
+    if (_size)
+    {
+        if (_output) _error |= fwrite(_buffer, 1, _size, _output) != _size;
+        else if (_sink) _sink->write(_buffer, _size, _sinkIndex);
+        _size = 0;
+    }
+    return !_error;
+}
+
+//=====================     Raw data    ==================================//
+
+void XmlWriter::put(const char* data, std::size_t n) noexcept
+{
+    if (n > _capacity - _size)
+    {
+        flush();
+        if (n >= _capacity) // too big to buffer; pass through
+        {
+            if (_output) _error |= fwrite(data, 1, n, _output) != n;
+            else if (_sink) _sink->write(data, n, _sinkIndex);
+            return;
+        }
+    }
+    memcpy(_buffer + _size, data, n);
+    _size += n;
+}
+
+void XmlWriter::write(const char* data, std::size_t n, std::size_t) noexcept
+{
+    closeTag();
+    put(data, n);
+}
+
+void XmlWriter::putEscaped(std::string_view s, bool attribute) noexcept
+{
+    static const simd::byte_set text_chars = { '&', '<', '>' };
+    static const simd::byte_set attribute_chars = { '&', '<', '>', '"' };
+    auto& set = attribute ? attribute_chars : text_chars;
+
+    auto p = s.data();
+    auto end = p + s.size();
+    while (p != end)
+    {
+        auto found = simd::find_first_of(p, end, set);
+        put(p, found - p);
+        if (found == end) break;
+        switch (*found)
+        {
+            case '&': put("&amp;"); break;
+            case '<': put("&lt;"); break;
+            case '>': put("&gt;"); break;
+            default:  put("&quot;"); break;
+        }
+        p = found + 1;
+    }
+}
+
+//=====================     Markup    ==================================//
+
+void XmlWriter::startElement(std::string_view name) noexcept
+{
+    closeTag();
+    put('<');
+    put(name);
+    _tagOpen = true;
+}
+
+void XmlWriter::writeAttribute(std::string_view name, std::string_view value) noexcept
+{
+    put(' ');
+    put(name);
+    put("=\"");
+    putEscaped(value, true);
+    put('"');
+}
+
+void XmlWriter::endElement(std::string_view name) noexcept
+{
+    if (_tagOpen)
+    {
+        _tagOpen = false;
+        put("/>");
+        return;
+    }
+    put("</");
+    put(name);
+    put('>');
+}
+
+void XmlWriter::writeText(std::string_view s) noexcept
+{
+    closeTag();
+    putEscaped(s, false);
+}
+
+void XmlWriter::writeCDATA(std::string_view s) noexcept
+{
+    closeTag();
+    put("<![CDATA[");
+    for (auto i = s.find("]]>"); i != s.npos; i = s.find("]]>")) // split the terminator
+    {
+        put(s.substr(0, i + 2));
+        put("]]><![CDATA[");
+        s.remove_prefix(i + 2);
+    }
+    put(s);
+    put("]]>");
+}
+
+void XmlWriter::writeComment(std::string_view s) noexcept
+{
+    closeTag();
+    put("<!--");
+    put(s);
+    put("-->");
+}
+
+//=====================     Copying from parser    ==================================//
+
+void XmlWriter::writeItem(const XmlParser& parser) noexcept
+{
+    std::string_view s = parser.getText();
+    if (parser.isEscapedText() && (parser.getOptions() & XmlParser::Options::kUnescapeText))
+    {
+        writeText(s);
+    }
+    else if (parser.isCDATA())
+    {
+        // one block for all pieces (see XmlParser::isPartial()); the text has 
+        // the tags unless kKeepCDATAtags, and never "]]>" inside
+        bool tags = !(parser.getOptions() & XmlParser::Options::kKeepCDATAtags);
+        closeTag();
+        if (!parser.isContinuation())
+        {
+            put("<![CDATA[");
+            if (tags) s.remove_prefix(std::min<std::size_t>(s.size(), 9));
+        }
+        if (tags && !parser.isPartial()) s.remove_suffix(std::min<std::size_t>(s.size(), 3));
+        put(s);
+        if (!parser.isPartial()) put("]]>");
+    }
+    else write(s);
+}
+
+bool XmlWriter::writeElement(XmlParser& parser) noexcept
+{
+    writeItem(parser);
+    if (!parser.isElement()) return true;
+    auto lvl = parser.getLevel();
+    for (;;)
+    {
+        if (parser.isElementEnd() && lvl == parser.getLevel()) return true;
+        if (!parser.next()) return false;
+        writeItem(parser);
+    }
+}
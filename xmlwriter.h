@@ -0,0 +1,107 @@
+#pragma once
+
+#include "processor.h"
+
+/// Buffered XML serializer.
+/// \detail Collects the output in a large buffer which is reused and passed
+/// to the file (or to another IWriter) only when full. Text and attribute
+/// values are escaped with a vectorized scan for the characters to replace.
+/// Being an IWriter itself, it can be passed to XmlParser::writeItem() and
+/// XmlParser::writeElement(); the userIndex is ignored then.
+class XmlWriter: public XmlParser::IWriter
+{
+    public:
+
+    static const std::size_t default_buffer_size = 0x100000;
+
+    /// Constructor. Allocates memory for the output buffer.
+    ///\ param bufferSize Size of output buffer.
+    XmlWriter(std::size_t bufferSize = default_buffer_size) noexcept;
+
+    /// Destructor. Flushes and closes any opened file and frees the buffer.
+    ~XmlWriter();
+
+    /// Opens a file for writing. A previous output will be closed.
+    ///\ param path Full path to the file.
+    /// \return True if opened succesfully, false otherwise
+    bool openFile(const char* path) noexcept;
+
+    /// Directs the output to another IWriter. A previous output will be closed.
+    ///\ param sink Receives the buffer each time it is flushed.
+    ///\ param userIndex Passed to the sink.
+    void open(IWriter& sink, std::size_t userIndex) noexcept;
+
+    /// Flushes the buffer and closes the output. This is done automatically
+    /// by openFile, open and destructor.
+    void closeFile() noexcept;
+
+    /// Passes the buffered data to the output.
+    /// \return False if writing to the file failed.
+    bool flush() noexcept;
+
+    /// True if writing to the file failed.
+    bool error() const noexcept { return _error; }
+
+    ///@{ Raw data
+
+    /// IWriter implementation; appends data as is.
+    virtual void write(const char* data, std::size_t n, std::size_t userIndex) noexcept;
+    using IWriter::write;
+
+    void write(std::string_view s) noexcept { write(s.data(), s.size(), 0); }
+
+    ///@}
+
+    ///@{ Markup
+
+    /// Writes "<name"; attributes can be added until any content is written.
+    void startElement(std::string_view name) noexcept;
+
+    /// Writes name="value" to a start-tag; the value is escaped.
+    void writeAttribute(std::string_view name, std::string_view value) noexcept;
+
+    /// Writes "</name>", or "/>" if the element has no content.
+    void endElement(std::string_view name) noexcept;
+
+    /// Writes text with '&', '<' and '>' escaped.
+    void writeText(std::string_view s) noexcept;
+
+    /// Writes a CDATA block.
+    void writeCDATA(std::string_view s) noexcept;
+
+    /// Writes a comment.
+    void writeComment(std::string_view s) noexcept;
+
+    ///@}
+
+    ///@{ Copying from parser
+
+    /// Writes parser's current item; unescaped text (see
+    /// XmlParser::Options::kUnescapeText) is escaped back. The pieces of a
+    /// CDATA (see XmlParser::isPartial()) make one block.
+    void writeItem(const XmlParser& parser) noexcept;
+
+    /// Writes parser's current element, including all its content, and
+    /// stops at the end-tag of this element.
+    /// \return False if EOF or data error occured before the end-tag.
+    bool writeElement(XmlParser& parser) noexcept;
+
+    ///@}
+
+    private:
+
+    char* _buffer;
+    std::size_t _capacity;
+    std::size_t _size;
+    FILE* _output;
+    IWriter* _sink;
+    std::size_t _sinkIndex;
+    bool _error;
+    bool _tagOpen;  // "<name" written, '>' not yet
+
+    void put(const char* data, std::size_t n) noexcept;
+    void put(char c) noexcept { if (_size == _capacity) flush(); _buffer[_size++] = c; }
+    void put(std::string_view s) noexcept { put(s.data(), s.size()); }
+    void closeTag() noexcept { if (_tagOpen) { _tagOpen = false; put('>'); } }
+    void putEscaped(std::string_view s, bool attribute) noexcept;
+};